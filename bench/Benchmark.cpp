@@ -0,0 +1,306 @@
+#include <GL/glew.h>
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Renderer.h"
+
+#include "VertexBuffer.h"
+#include "VertexBufferLayout.h"
+#include "IndexBuffer.h"
+#include "VertexArray.h"
+#include "Shader.h"
+#include "ProgramBinaryCache.h"
+#include "MeshPacker.h"
+#include "StreamBuffer.h"
+#include "BufferArena.h"
+
+#include "Context.h"
+
+// Draw throughput benchmark, headless by default so it runs on CI/render nodes.
+//   --window       use a GLFW window instead (vsync is on, so this measures the display too)
+//   --frames N     frames to render (default 1000)
+//   --draws N      draw calls per frame (default 1000)
+//   --deferred     record with Renderer::Submit and draw in Renderer::Flush
+//   --threads N    with --deferred, record on N worker threads (spawned every frame)
+//   --instanced    draw all quads with one instanced call (Renderer::DrawInstanced)
+//   --packed       every quad is its own mesh in one shared VB/IB (MeshPacker), submitted as
+//                  ranges so Flush can merge them into multi-draw indirect calls
+//   --stream       rewrite all quads every frame into a StreamBuffer and draw them with one call
+//   --arena        every quad gets its own index buffer, sub-allocated from one BufferArena, and is
+//                  submitted as a normal draw; Flush merges them since they share a buffer object
+//   --no-dsa       create/edit resources with bind-to-edit even when direct state access is available
+//   --gl-check P   none|frame|call, runtime GL error policy (call needs a KLGL_GL_CHECK=CALL build)
+//   --shader-cache DIR  load/store program binaries in DIR, the shader creation time is printed either way
+//   --async-shaders     compile shaders without waiting (Shader::SetAsyncCompilation)
+int main(int argc, char** argv)
+{
+    ContextType contextType = ContextType::Headless;
+    unsigned int frameCount = 1000;
+    unsigned int drawsPerFrame = 1000;
+    bool deferred = false;
+    unsigned int threadCount = 0;
+    bool instanced = false;
+    bool packed = false;
+    bool stream = false;
+    bool arena = false;
+    bool asyncShaders = false;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg == "--window")
+            contextType = ContextType::Window;
+        else if (arg == "--frames" && i + 1 < argc)
+            frameCount = (unsigned int)std::stoul(argv[++i]);
+        else if (arg == "--draws" && i + 1 < argc)
+            drawsPerFrame = (unsigned int)std::stoul(argv[++i]);
+        else if (arg == "--deferred")
+            deferred = true;
+        else if (arg == "--threads" && i + 1 < argc)
+            threadCount = (unsigned int)std::stoul(argv[++i]);
+        else if (arg == "--instanced")
+            instanced = true;
+        else if (arg == "--packed")
+            packed = true;
+        else if (arg == "--stream")
+            stream = true;
+        else if (arg == "--arena")
+            arena = true;
+        else if (arg == "--no-dsa")
+            Renderer::SetDirectStateAccessEnabled(false);
+        else if (arg == "--async-shaders")
+            asyncShaders = true;
+        else if (arg == "--shader-cache" && i + 1 < argc)
+            ProgramBinaryCache::SetDirectory(argv[++i]);
+        else if (arg == "--gl-check" && i + 1 < argc)
+        {
+            std::string policy = argv[++i];
+            if (policy == "none")
+                GLSetErrorPolicy(GLErrorPolicy::None);
+            else if (policy == "frame")
+                GLSetErrorPolicy(GLErrorPolicy::PerFrame);
+            else if (policy == "call")
+                GLSetErrorPolicy(GLErrorPolicy::PerCall);
+        }
+    }
+
+    Context context(contextType, 640, 480, "klgl_bench");
+    if (!context.IsValid())
+        return -1;
+    if (asyncShaders)
+        Shader::SetAsyncCompilation(true);
+
+    {
+        // tiny quad so fill rate (llvmpipe!) doesn't hide the CPU side
+        float positions[8] = {
+            -0.01f, -0.01f,
+             0.01f, -0.01f,
+             0.01f,  0.01f,
+            -0.01f,  0.01f
+        };
+
+        unsigned int indices[] = {
+            0, 1, 2,
+            2, 3, 0
+        };
+
+        VertexArray va;
+        VertexBuffer vb(positions, 4 * 2 * sizeof(float));
+
+        VertexBufferLayout layout;
+        layout.Push<float>(2);
+        va.AddBuffer(vb, layout);
+
+        IndexBuffer ib(indices, 6);
+
+        // both shaders up front, so with --async-shaders their compiles overlap
+        auto shaderStart = std::chrono::steady_clock::now();
+        Shader shader("res/shaders/Basic.shader");
+        Shader instancedShader("res/shaders/Instanced.shader");
+        std::chrono::duration<double, std::milli> submitTime = std::chrono::steady_clock::now() - shaderStart;
+        shader.WaitUntilReady();
+        instancedShader.WaitUntilReady();
+        std::chrono::duration<double, std::milli> shaderTime = std::chrono::steady_clock::now() - shaderStart;
+        std::cout << "shaders: " << shaderTime.count() << " ms (" << submitTime.count() << " ms in the constructors)"
+                  << (ProgramBinaryCache::GetHitCount() ? ", binary cache hit" : "") << "\n";
+        shader.Bind();
+        shader.SetUniform4f("u_Color", 0.0f, 0.0f, 1.0f, 1.0f);
+
+        // per instance: vec2 offset + vec4 color, laid out on a grid
+        std::vector<float> instanceData;
+        instanceData.reserve(drawsPerFrame * 6);
+        unsigned int columns = 1;
+        while (columns * columns < drawsPerFrame)
+            columns++;
+        for (unsigned int i = 0; i < drawsPerFrame; i++)
+        {
+            float x = (i % columns + 0.5f) / columns * 2.0f - 1.0f;
+            float y = (i / columns + 0.5f) / columns * 2.0f - 1.0f;
+            instanceData.insert(instanceData.end(), { x, y, x * 0.5f + 0.5f, y * 0.5f + 0.5f, 1.0f, 1.0f });
+        }
+
+        VertexArray instancedVa;
+        VertexBuffer instanceVb(instanceData.data(), (unsigned int)(instanceData.size() * sizeof(float)));
+        VertexBufferLayout instanceLayout;
+        instanceLayout.PushInstanced<float>(2);
+        instanceLayout.PushInstanced<float>(4);
+        if (instanced)
+        {
+            instancedVa.AddBuffer(vb, layout);
+            instancedVa.AddBuffer(instanceVb, instanceLayout);
+        }
+
+        // the same quads baked into one shared buffer pair
+        MeshPacker packer(2 * sizeof(float));
+        std::vector<IndexRange> ranges;
+        if (packed)
+        {
+            for (unsigned int i = 0; i < drawsPerFrame; i++)
+            {
+                float quad[8];
+                for (int v = 0; v < 8; v++)
+                    quad[v] = positions[v] + instanceData[i * 6 + v % 2];
+                ranges.push_back(packer.Add(quad, 4, indices, 6));
+            }
+        }
+        VertexArray packedVa;
+        VertexBuffer packedVb(packer.GetVertexData(), packer.GetVertexDataSize());
+        IndexBuffer packedIb(packer.GetIndexData(), packer.GetIndexCount());
+        if (packed)
+            packedVa.AddBuffer(packedVb, layout);
+
+        // one index buffer for drawsPerFrame quads, the vertices are streamed
+        std::vector<unsigned int> quadIndices;
+        if (stream)
+        {
+            for (unsigned int i = 0; i < drawsPerFrame; i++)
+                for (unsigned int index : indices)
+                    quadIndices.push_back(i * 4 + index);
+        }
+        const unsigned int streamStride = 2 * sizeof(float);
+        StreamBuffer streamBuffer(stream ? drawsPerFrame * 4 * streamStride : 4, 3);
+        IndexBuffer quadIb(quadIndices.data(), (unsigned int)quadIndices.size());
+        VertexArray streamVa;
+        if (stream)
+            streamVa.AddBuffer(streamBuffer.GetBuffer(), layout);
+
+        // all quads in one arena vertex buffer, one small index buffer per quad next to it
+        BufferArena bufferArena(1024 * 1024);
+        std::unique_ptr<VertexBuffer> arenaVb;
+        std::vector<IndexBuffer> arenaIbs;
+        VertexArray arenaVa;
+        if (arena)
+        {
+            std::vector<float> quads;
+            for (unsigned int i = 0; i < drawsPerFrame; i++)
+                for (int v = 0; v < 8; v++)
+                    quads.push_back(positions[v] + instanceData[i * 6 + v % 2]);
+            arenaVb = std::make_unique<VertexBuffer>(bufferArena, quads.data(), (unsigned int)(quads.size() * sizeof(float)));
+            arenaVa.AddBuffer(*arenaVb, layout);
+
+            arenaIbs.reserve(drawsPerFrame);
+            for (unsigned int i = 0; i < drawsPerFrame; i++)
+            {
+                unsigned int quadIndices[6];
+                for (int j = 0; j < 6; j++)
+                    quadIndices[j] = i * 4 + indices[j];
+                arenaIbs.emplace_back(bufferArena, quadIndices, 6);
+            }
+            std::cout << "arena: " << bufferArena.GetBlockCount() << " block(s), "
+                << bufferArena.GetUsedBytes() << " bytes used\n";
+        }
+
+        Renderer renderer;
+        renderer.SetWorkerCount(threadCount);
+        std::vector<std::thread> workers(threadCount);
+
+        auto start = std::chrono::steady_clock::now();
+        for (unsigned int frame = 0; frame < frameCount && !context.ShouldClose(); frame++)
+        {
+            GLCall(glClear(GL_COLOR_BUFFER_BIT));
+
+            if (stream)
+            {
+                unsigned int offset = 0;
+                float* vertices = (float*)streamBuffer.Map(drawsPerFrame * 4 * streamStride, offset, streamStride);
+                float wobble = (frame % 64) / 640.0f;
+                for (unsigned int i = 0; i < drawsPerFrame; i++)
+                {
+                    for (int v = 0; v < 8; v++)
+                        *vertices++ = positions[v] + instanceData[i * 6 + v % 2] + wobble;
+                }
+                streamBuffer.Unmap();
+                renderer.DrawRange(streamVa, quadIb, shader, { quadIb.GetCount(), 0, (int)(offset / streamStride) });
+                streamBuffer.Advance();
+            }
+            else if (arena)
+            {
+                for (unsigned int i = 0; i < drawsPerFrame; i++)
+                    renderer.Submit(arenaVa, arenaIbs[i], shader, 0, (float)i / drawsPerFrame);
+                renderer.Flush();
+            }
+            else if (packed)
+            {
+                for (unsigned int i = 0; i < drawsPerFrame; i++)
+                    renderer.SubmitRange(packedVa, packedIb, shader, ranges[i]);
+                renderer.Flush();
+            }
+            else if (instanced)
+            {
+                renderer.DrawInstanced(instancedVa, ib, instancedShader, drawsPerFrame);
+            }
+            else if (deferred && threadCount > 0)
+            {
+                for (unsigned int t = 0; t < threadCount; t++)
+                {
+                    workers[t] = std::thread([&, t]()
+                    {
+                        CommandBuffer& queue = renderer.GetWorkerQueue(t);
+                        for (unsigned int i = t; i < drawsPerFrame; i += threadCount)
+                            queue.Submit(va, ib, shader, 0, (float)i / drawsPerFrame);
+                    });
+                }
+                for (std::thread& worker : workers)
+                    worker.join();
+                renderer.Flush();
+            }
+            else if (deferred)
+            {
+                for (unsigned int i = 0; i < drawsPerFrame; i++)
+                    renderer.Submit(va, ib, shader, 0, (float)i / drawsPerFrame);
+                renderer.Flush();
+            }
+            else
+            {
+                for (unsigned int i = 0; i < drawsPerFrame; i++)
+                    renderer.Draw(va, ib, shader);
+            }
+
+            renderer.EndFrame();
+            context.SwapBuffers();
+            context.PollEvents();
+        }
+        GLCall(glFinish());
+        auto end = std::chrono::steady_clock::now();
+
+        double seconds = std::chrono::duration<double>(end - start).count();
+        // counts instances as draws so the modes are comparable
+        double draws = (double)frameCount * drawsPerFrame;
+        std::cout << frameCount << " frames x " << drawsPerFrame << " draws in " << seconds << " s\n";
+        std::cout << "  " << seconds * 1000.0 / frameCount << " ms/frame, "
+            << draws / seconds / 1e6 << " M draws/s, "
+            << seconds * 1e9 / draws << " ns/draw" << std::endl;
+
+        const RenderStats& stats = renderer.GetFrameStats();
+        std::cout << "  last frame: " << stats.DrawCalls << " draws, "
+            << stats.ProgramBinds + stats.VertexArrayBinds + stats.BufferBinds << " binds issued, "
+            << stats.SkippedBinds << " redundant binds skipped, "
+            << stats.IndirectDraws << " draws through multi-draw indirect" << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,27 @@
+#shader vertex
+#version 330 core
+
+layout(location = 0) in vec4 position;
+// per instance
+layout(location = 1) in vec2 offset;
+layout(location = 2) in vec4 color;
+
+out vec4 v_Color;
+
+void main()
+{
+    gl_Position = vec4(position.xy + offset, position.zw);
+    v_Color = color;
+}
+
+#shader fragment
+#version 330 core
+
+layout(location = 0) out vec4 color;
+
+in vec4 v_Color;
+
+void main()
+{
+    color = v_Color;
+}
@@ -1,10 +1,10 @@
 #include <GL/glew.h>
-#include <GLFW/glfw3.h>
 
 #include <iostream>
 #include <fstream>
 #include <string>
 #include <sstream>
+#include <vector>
 
 #include "Renderer.h"
 
@@ -13,39 +13,70 @@
 #include "IndexBuffer.h"
 #include "VertexArray.h"
 #include "Shader.h"
+#include "ProgramBinaryCache.h"
+#include "ShaderHotReload.h"
+
+#include "Context.h"
+#include "GLDebug.h"
 
 // Get shader file line by line
 
-int main(void)
+// dump an RGBA8 bottom-up framebuffer as a binary PPM
+static bool WritePPM(const std::string& filepath, const std::vector<unsigned char>& pixels, unsigned int width, unsigned int height)
 {
-    GLFWwindow* window;
-
-    /* Initialize the library */
-    if (!glfwInit())
-        return -1;
-
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_COMPAT_PROFILE);
-
-    /* Create a windowed mode window and its OpenGL context */
-    window = glfwCreateWindow(640, 480, "Hello World", NULL, NULL);
-    if (!window)
+    std::ofstream stream(filepath, std::ios::binary);
+    if (!stream)
+        return false;
+
+    stream << "P6\n" << width << " " << height << "\n255\n";
+    for (unsigned int y = height; y-- > 0;)
+        for (unsigned int x = 0; x < width; x++)
+            stream.write((const char*)&pixels[((size_t)y * width + x) * 4], 3);
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    // --headless     render offscreen through EGL, no window/display needed
+    // --frames N     stop after N frames (headless defaults to 1)
+    // --output FILE  write the last headless frame as .ppm
+    // --gl-debug     debug context + KHR_debug output instead of glGetError polling
+    // --no-dsa       bind-to-edit resource setup even when direct state access is available
+    // --shader-cache DIR  where linked program binaries are kept (default shadercache/), "" turns it off
+    // --hot-reload   reload shaders when their files change
+    ContextType contextType = ContextType::Window;
+    unsigned int frameLimit = 0;
+    std::string outputPath;
+    bool glDebug = false;
+    ProgramBinaryCache::SetDirectory("shadercache");
+    for (int i = 1; i < argc; i++)
     {
-        glfwTerminate();
-        return -1;
+        std::string arg = argv[i];
+        if (arg == "--headless")
+            contextType = ContextType::Headless;
+        else if (arg == "--frames" && i + 1 < argc)
+            frameLimit = (unsigned int)std::stoul(argv[++i]);
+        else if (arg == "--output" && i + 1 < argc)
+            outputPath = argv[++i];
+        else if (arg == "--gl-debug")
+            glDebug = true;
+        else if (arg == "--no-dsa")
+            Renderer::SetDirectStateAccessEnabled(false);
+        else if (arg == "--shader-cache" && i + 1 < argc)
+            ProgramBinaryCache::SetDirectory(argv[++i]);
+        else if (arg == "--hot-reload")
+            ShaderHotReload::Enable();
     }
+    if (contextType == ContextType::Headless && frameLimit == 0)
+        frameLimit = 1;
 
-    /* Make the window's context current */
-    glfwMakeContextCurrent(window);
-     
-    glfwSwapInterval(1); // Enable vsync
+    Context context(contextType, 640, 480, "Hello World", glDebug);
+    if (!context.IsValid())
+        return -1;
 
-    // glewInit has to be done in the context 
-    if (glewInit() != GLEW_OK)
-		std::cout << "Error!" << std::endl; 
+    if (glDebug)
+        GLDebugOutput::Enable(GLDebugSeverity::Low);
 
-    std::cout << glGetString(GL_VERSION) << std::endl;
     {
         float positions[8] = {
             -0.5f, -0.5f, // 0
@@ -83,7 +114,8 @@ int main(void)
         Renderer renderer;
 
         /* Loop until the user closes the window */
-        while (!glfwWindowShouldClose(window))
+        unsigned int frame = 0;
+        while (!context.ShouldClose() && (frameLimit == 0 || frame < frameLimit))
         {
             /* Render here */
             GLCall(glClear(GL_COLOR_BUFFER_BIT));
@@ -95,15 +127,25 @@ int main(void)
 
             GLCall(glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, nullptr));
 
+            renderer.EndFrame();
+
             /* Swap front and back buffers */
-            glfwSwapBuffers(window);
+            context.SwapBuffers();
 
             /* Poll for and process events */
-            glfwPollEvents();
+            context.PollEvents();
+            frame++;
         }
 
+        if (!outputPath.empty() && context.GetFrameBuffer())
+        {
+            const FrameBuffer& fb = *context.GetFrameBuffer();
+            if (!WritePPM(outputPath, fb.ReadPixels(), fb.GetWidth(), fb.GetHeight()))
+                std::cout << "Failed to write " << outputPath << std::endl;
+        }
     }
 
-    glfwTerminate();
+    GLDebugOutput::Disable();
+
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,159 @@
+#include "BufferArena.h"
+
+#include "Renderer.h"
+#include "DeletionQueue.h"
+
+BufferArena::BufferArena(unsigned int blockSize)
+    : m_BlockSize(blockSize)
+{
+}
+
+BufferArena::~BufferArena()
+{
+    DeletionQueue::ForgetArena(*this);
+    for (Block& block : m_Blocks)
+    {
+        DeletionQueue::Enqueue(GLObjectType::Buffer, block.rendererID);
+    }
+}
+
+BufferAllocation BufferArena::Allocate(unsigned int size, unsigned int alignment)
+{
+    BufferAllocation allocation = { 0, 0, 0, 0 };
+    if (size == 0)
+        return allocation;
+    if (alignment == 0)
+        alignment = 1;
+
+    for (unsigned int i = 0; i < m_Blocks.size(); i++)
+    {
+        if (AllocateFromBlock(i, size, alignment, allocation))
+            return allocation;
+    }
+
+    // new block, bigger than usual if the request doesn't fit a regular one
+    Block block;
+    block.size = size > m_BlockSize ? size : m_BlockSize;
+    block.used = 0;
+    if (Renderer::UseDirectStateAccess())
+    {
+        GLCall(glCreateBuffers(1, &block.rendererID));
+        GLCall(glNamedBufferStorage(block.rendererID, block.size, nullptr, GL_DYNAMIC_STORAGE_BIT));
+    }
+    else
+    {
+        GLCall(glGenBuffers(1, &block.rendererID));
+        GLCall(glBindBuffer(GL_COPY_WRITE_BUFFER, block.rendererID));
+        GLCall(glBufferData(GL_COPY_WRITE_BUFFER, block.size, nullptr, GL_STATIC_DRAW));
+        GLCall(glBindBuffer(GL_COPY_WRITE_BUFFER, 0));
+    }
+    InsertFree(block, 0, block.size);
+    m_Blocks.push_back(std::move(block));
+
+    AllocateFromBlock((unsigned int)m_Blocks.size() - 1, size, alignment, allocation);
+    return allocation;
+}
+
+bool BufferArena::AllocateFromBlock(unsigned int index, unsigned int size, unsigned int alignment, BufferAllocation& allocation)
+{
+    Block& block = m_Blocks[index];
+    if (block.size - block.used < size)
+        return false;
+
+    // best fit: smallest free range that still holds size after alignment padding
+    for (auto it = block.freeBySize.lower_bound(size); it != block.freeBySize.end(); ++it)
+    {
+        unsigned int rangeOffset = it->second;
+        unsigned int rangeSize = it->first;
+        unsigned int offset = (rangeOffset + alignment - 1) / alignment * alignment;
+        unsigned int padding = offset - rangeOffset;
+        if (rangeSize < padding + size)
+            continue;
+
+        EraseFree(block, block.freeByOffset.find(rangeOffset));
+        // give back what is left on either side
+        if (padding > 0)
+            InsertFree(block, rangeOffset, padding);
+        if (rangeSize > padding + size)
+            InsertFree(block, offset + size, rangeSize - padding - size);
+
+        block.used += size;
+        allocation = { block.rendererID, index, offset, size };
+        return true;
+    }
+    return false;
+}
+
+void BufferArena::Free(const BufferAllocation& allocation)
+{
+    if (allocation.buffer == 0)
+        return;
+
+    Block& block = m_Blocks[allocation.block];
+    block.used -= allocation.size;
+
+    unsigned int offset = allocation.offset;
+    unsigned int size = allocation.size;
+
+    // merge with the free neighbours
+    auto next = block.freeByOffset.lower_bound(offset);
+    if (next != block.freeByOffset.end() && next->first == offset + size)
+    {
+        size += next->second;
+        EraseFree(block, next);
+    }
+    auto prev = block.freeByOffset.lower_bound(offset);
+    if (prev != block.freeByOffset.begin())
+    {
+        --prev;
+        if (prev->first + prev->second == offset)
+        {
+            offset = prev->first;
+            size += prev->second;
+            EraseFree(block, prev);
+        }
+    }
+    InsertFree(block, offset, size);
+}
+
+void BufferArena::Upload(const BufferAllocation& allocation, const void* data, unsigned int size, unsigned int offset)
+{
+    ASSERT(offset + size <= allocation.size);
+    if (Renderer::UseDirectStateAccess())
+    {
+        GLCall(glNamedBufferSubData(allocation.buffer, allocation.offset + offset, size, data));
+        return;
+    }
+
+    // the copy-write target isn't used for drawing, so binding it doesn't invalidate RenderState
+    GLCall(glBindBuffer(GL_COPY_WRITE_BUFFER, allocation.buffer));
+    GLCall(glBufferSubData(GL_COPY_WRITE_BUFFER, allocation.offset + offset, size, data));
+}
+
+unsigned int BufferArena::GetUsedBytes() const
+{
+    unsigned int used = 0;
+    for (const Block& block : m_Blocks)
+        used += block.used;
+    return used;
+}
+
+void BufferArena::InsertFree(Block& block, unsigned int offset, unsigned int size)
+{
+    block.freeByOffset[offset] = size;
+    block.freeBySize.insert({ size, offset });
+}
+
+void BufferArena::EraseFree(Block& block, std::map<unsigned int, unsigned int>::iterator it)
+{
+    auto range = block.freeBySize.equal_range(it->second);
+    for (auto sizeIt = range.first; sizeIt != range.second; ++sizeIt)
+    {
+        if (sizeIt->second == it->first)
+        {
+            block.freeBySize.erase(sizeIt);
+            break;
+        }
+    }
+    block.freeByOffset.erase(it);
+}
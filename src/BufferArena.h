@@ -0,0 +1,57 @@
+#pragma once
+
+#include <map>
+#include <vector>
+
+// a piece of one of the arena's GL buffers
+struct BufferAllocation
+{
+	unsigned int buffer;   // GL name of the block's buffer, 0 = invalid
+	unsigned int block;
+	unsigned int offset;   // bytes
+	unsigned int size;     // bytes
+};
+
+// Sub-allocates vertex/index storage out of a few large GL buffers instead of one
+// buffer object per VertexBuffer/IndexBuffer. Each block keeps an offset-ordered
+// free list (neighbours coalesce on Free) plus a size-ordered index for best fit.
+// Blocks are allocated on demand; requests larger than the block size get a block of their own.
+class BufferArena
+{
+private:
+	struct Block
+	{
+		unsigned int rendererID;
+		unsigned int size;
+		unsigned int used;
+		// offset -> size
+		std::map<unsigned int, unsigned int> freeByOffset;
+		// size -> offset
+		std::multimap<unsigned int, unsigned int> freeBySize;
+	};
+
+	unsigned int m_BlockSize;
+	std::vector<Block> m_Blocks;
+public:
+	// blockSize - bytes per GL buffer
+	BufferArena(unsigned int blockSize = 16 * 1024 * 1024);
+	~BufferArena();
+
+	BufferArena(const BufferArena&) = delete;
+	BufferArena& operator=(const BufferArena&) = delete;
+
+	// offset is a multiple of alignment (use the vertex stride to be able to address it with a base vertex)
+	BufferAllocation Allocate(unsigned int size, unsigned int alignment = 16);
+	// GL thread, right away. Views (VertexBuffer/IndexBuffer) free through DeletionQueue::EnqueueFree
+	void Free(const BufferAllocation& allocation);
+
+	// copy into [allocation.offset + offset, ...) without disturbing any buffer bindings
+	void Upload(const BufferAllocation& allocation, const void* data, unsigned int size, unsigned int offset = 0);
+
+	inline unsigned int GetBlockCount() const { return (unsigned int)m_Blocks.size(); }
+	unsigned int GetUsedBytes() const;
+private:
+	bool AllocateFromBlock(unsigned int block, unsigned int size, unsigned int alignment, BufferAllocation& allocation);
+	void InsertFree(Block& block, unsigned int offset, unsigned int size);
+	void EraseFree(Block& block, std::map<unsigned int, unsigned int>::iterator it);
+};
@@ -0,0 +1,84 @@
+#include "CommandBuffer.h"
+
+#include "Renderer.h"
+
+uint64_t SortKey::Make(const Shader& shader, const VertexArray& va, unsigned int material, float depth)
+{
+    if (depth < 0.0f)
+        depth = 0.0f;
+    else if (depth > 1.0f)
+        depth = 1.0f;
+
+    uint64_t vaoKey = va.GetRendererID() & 0xFFFF;
+
+    return ((uint64_t)(shader.GetRendererID() & 0xFFFF) << 48)
+        | (vaoKey << 32)
+        | ((uint64_t)(material & 0xFF) << 24)
+        | (uint64_t)(depth * 0xFFFFFF);
+}
+
+void CommandBuffer::Submit(const VertexArray& va, const IndexBuffer& ib, const Shader& shader, unsigned int material, float depth)
+{
+    m_Commands.push_back({ SortKey::Make(shader, va, material, depth), &va, &ib, &shader, ib.GetCount(), 1, 0, 0 });
+}
+
+void CommandBuffer::SubmitInstanced(const VertexArray& va, const IndexBuffer& ib, const Shader& shader, unsigned int instanceCount, unsigned int material, float depth)
+{
+    m_Commands.push_back({ SortKey::Make(shader, va, material, depth), &va, &ib, &shader, ib.GetCount(), instanceCount, 0, 0 });
+}
+
+void CommandBuffer::SubmitRange(const VertexArray& va, const IndexBuffer& ib, const Shader& shader, const IndexRange& range, unsigned int material, float depth)
+{
+    m_Commands.push_back({ SortKey::Make(shader, va, material, depth), &va, &ib, &shader, range.count, 1, range.firstIndex, range.baseVertex });
+}
+
+void CommandBuffer::Clear()
+{
+    m_Commands.clear();
+}
+
+void RadixSort(std::vector<SortEntry>& entries, std::vector<SortEntry>& scratch)
+{
+    const size_t count = entries.size();
+    if (count < 2)
+        return;
+
+    // all 8 histograms in one pass over the data
+    size_t histograms[8][256] = {};
+    for (const SortEntry& entry : entries)
+    {
+        for (int pass = 0; pass < 8; pass++)
+            histograms[pass][(entry.key >> (pass * 8)) & 0xFF]++;
+    }
+
+    scratch.resize(count);
+    SortEntry* src = entries.data();
+    SortEntry* dst = scratch.data();
+    for (int pass = 0; pass < 8; pass++)
+    {
+        size_t* histogram = histograms[pass];
+        const int shift = pass * 8;
+
+        // every key shares this byte, nothing to reorder
+        if (histogram[(src[0].key >> shift) & 0xFF] == count)
+            continue;
+
+        size_t offset = 0;
+        for (int i = 0; i < 256; i++)
+        {
+            size_t n = histogram[i];
+            histogram[i] = offset;
+            offset += n;
+        }
+
+        for (size_t i = 0; i < count; i++)
+            dst[histogram[(src[i].key >> shift) & 0xFF]++] = src[i];
+
+        SortEntry* temp = src;
+        src = dst;
+        dst = temp;
+    }
+
+    if (src != entries.data())
+        entries.swap(scratch);
+}
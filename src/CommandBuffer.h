@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "IndexBuffer.h"
+
+class VertexArray;
+class Shader;
+
+// one recorded draw, everything Renderer::Flush needs to issue it
+struct RenderCommand
+{
+	uint64_t key;
+	const VertexArray* va;
+	const IndexBuffer* ib;
+	const Shader* shader;
+	unsigned int count;
+	// 1 = plain draw, more goes through glDrawElementsInstanced
+	unsigned int instanceCount;
+	// sub-range of a shared index buffer, 0/0 for a whole IndexBuffer
+	unsigned int firstIndex;
+	int baseVertex;
+};
+
+// 64-bit sort key, most significant first:
+//   [63..48] shader program
+//   [47..32] vertex array
+//   [31..24] material (caller-defined id, only affects ordering)
+//   [23..0]  depth, quantized from [0, 1], front to back
+// Sorting by key groups draws by state so consecutive commands rarely need a bind.
+namespace SortKey
+{
+	uint64_t Make(const Shader& shader, const VertexArray& va, unsigned int material, float depth);
+}
+
+// Linear list of draws recorded without touching GL, so any thread can fill one.
+// Cache line aligned so per-worker buffers sitting next to each other don't false-share.
+class alignas(64) CommandBuffer
+{
+private:
+	std::vector<RenderCommand> m_Commands;
+public:
+	void Submit(const VertexArray& va, const IndexBuffer& ib, const Shader& shader, unsigned int material = 0, float depth = 0.0f);
+	void SubmitInstanced(const VertexArray& va, const IndexBuffer& ib, const Shader& shader, unsigned int instanceCount, unsigned int material = 0, float depth = 0.0f);
+	void SubmitRange(const VertexArray& va, const IndexBuffer& ib, const Shader& shader, const IndexRange& range, unsigned int material = 0, float depth = 0.0f);
+	void Clear();
+
+	inline const std::vector<RenderCommand>& GetCommands() const { return m_Commands; }
+	inline size_t Size() const { return m_Commands.size(); }
+};
+
+struct SortEntry
+{
+	uint64_t key;
+	const RenderCommand* command;
+};
+
+// stable LSD radix sort on the key, 8 bits per pass; passes where every key
+// has the same byte are skipped. scratch is reused between calls.
+void RadixSort(std::vector<SortEntry>& entries, std::vector<SortEntry>& scratch);
@@ -0,0 +1,230 @@
+#include "Context.h"
+
+#include <iostream>
+#include <cstring>
+
+#include "Renderer.h"
+#include "DeletionQueue.h"
+
+#ifndef KLGL_NO_GLFW
+#include <GLFW/glfw3.h>
+#endif
+
+// EGL is what lets us run without a display server, it isn't available on Windows/macOS
+#if !defined(_WIN32) && !defined(__APPLE__) && !defined(KLGL_NO_EGL)
+#define KLGL_HAS_EGL
+#define EGL_NO_X11
+#define MESA_EGL_NO_X11_HEADERS
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+Context::Context(ContextType type, unsigned int width, unsigned int height, const std::string& title, bool debug)
+    : m_Type(type), m_Width(width), m_Height(height), m_Window(nullptr),
+      m_Display(nullptr), m_Context(nullptr), m_Surface(nullptr), m_Valid(false)
+{
+    if (type == ContextType::Window)
+        m_Valid = CreateWindowContext(title, debug);
+    else
+        m_Valid = CreateHeadlessContext(debug);
+
+    if (!m_Valid)
+        return;
+
+    std::cout << glGetString(GL_VERSION) << " (" << glGetString(GL_RENDERER) << ")" << std::endl;
+
+    // surfaceless contexts have no default framebuffer, draw into our own
+    if (type == ContextType::Headless)
+    {
+        m_FrameBuffer = std::make_unique<FrameBuffer>(width, height);
+        m_FrameBuffer->Bind();
+    }
+}
+
+Context::~Context()
+{
+    // GL objects have to go while the context is still current
+    m_FrameBuffer.reset();
+    DeletionQueue::Flush();
+
+#ifndef KLGL_NO_GLFW
+    if (m_Window)
+        glfwTerminate();
+#endif
+
+#ifdef KLGL_HAS_EGL
+    if (m_Display)
+    {
+        EGLDisplay display = (EGLDisplay)m_Display;
+        eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        if (m_Surface)
+            eglDestroySurface(display, (EGLSurface)m_Surface);
+        if (m_Context)
+            eglDestroyContext(display, (EGLContext)m_Context);
+        eglTerminate(display);
+    }
+#endif
+}
+
+bool Context::ShouldClose() const
+{
+#ifndef KLGL_NO_GLFW
+    if (m_Window)
+        return glfwWindowShouldClose(m_Window);
+#endif
+    return false;
+}
+
+void Context::SwapBuffers()
+{
+#ifndef KLGL_NO_GLFW
+    if (m_Window)
+    {
+        glfwSwapBuffers(m_Window);
+        return;
+    }
+#endif
+    GLCall(glFlush());
+}
+
+void Context::PollEvents()
+{
+#ifndef KLGL_NO_GLFW
+    if (m_Window)
+        glfwPollEvents();
+#endif
+}
+
+bool Context::CreateWindowContext(const std::string& title, bool debug)
+{
+#ifndef KLGL_NO_GLFW
+    /* Initialize the library */
+    if (!glfwInit())
+        return false;
+
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_COMPAT_PROFILE);
+    glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, debug ? GLFW_TRUE : GLFW_FALSE);
+
+    /* Create a windowed mode window and its OpenGL context */
+    m_Window = glfwCreateWindow(m_Width, m_Height, title.c_str(), NULL, NULL);
+    if (!m_Window)
+    {
+        glfwTerminate();
+        return false;
+    }
+
+    /* Make the window's context current */
+    glfwMakeContextCurrent(m_Window);
+
+    glfwSwapInterval(1); // Enable vsync
+
+    return InitGlew();
+#else
+    (void)title; (void)debug;
+    std::cout << "Built without GLFW, only headless contexts are available" << std::endl;
+    return false;
+#endif
+}
+
+bool Context::CreateHeadlessContext(bool debug)
+{
+#ifdef KLGL_HAS_EGL
+    EGLDisplay display = EGL_NO_DISPLAY;
+
+    // prefer the surfaceless platform, it needs neither a GPU nor a display server
+    const char* clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    if (clientExtensions && strstr(clientExtensions, "EGL_MESA_platform_surfaceless"))
+    {
+        auto getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+        if (getPlatformDisplay)
+            display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    }
+    if (display == EGL_NO_DISPLAY)
+        display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, nullptr, nullptr))
+    {
+        std::cout << "Failed to initialize EGL display" << std::endl;
+        return false;
+    }
+    m_Display = display;
+
+    if (!eglBindAPI(EGL_OPENGL_API))
+    {
+        std::cout << "EGL implementation has no desktop OpenGL" << std::endl;
+        return false;
+    }
+
+    const EGLint configAttribs[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+        EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8, EGL_ALPHA_SIZE, 8,
+        EGL_NONE
+    };
+    EGLConfig config;
+    EGLint configCount = 0;
+    if (!eglChooseConfig(display, configAttribs, &config, 1, &configCount) || configCount == 0)
+    {
+        std::cout << "No suitable EGL config" << std::endl;
+        return false;
+    }
+
+    // same version/profile as the window path
+    const EGLint contextAttribs[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 3,
+        EGL_CONTEXT_MINOR_VERSION, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_COMPATIBILITY_PROFILE_BIT,
+        EGL_CONTEXT_OPENGL_DEBUG, debug ? EGL_TRUE : EGL_FALSE,
+        EGL_NONE
+    };
+    EGLContext context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttribs);
+    if (context == EGL_NO_CONTEXT)
+    {
+        std::cout << "Failed to create EGL context (" << eglGetError() << ")" << std::endl;
+        return false;
+    }
+    m_Context = context;
+
+    // without EGL_KHR_surfaceless_context we need a dummy pbuffer to make the context current
+    EGLSurface surface = EGL_NO_SURFACE;
+    const char* displayExtensions = eglQueryString(display, EGL_EXTENSIONS);
+    if (!displayExtensions || !strstr(displayExtensions, "EGL_KHR_surfaceless_context"))
+    {
+        const EGLint pbufferAttribs[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+        surface = eglCreatePbufferSurface(display, config, pbufferAttribs);
+        m_Surface = surface;
+    }
+
+    if (!eglMakeCurrent(display, surface, surface, context))
+    {
+        std::cout << "Failed to make EGL context current (" << eglGetError() << ")" << std::endl;
+        return false;
+    }
+
+    return InitGlew();
+#else
+    (void)debug;
+    std::cout << "Headless contexts need EGL, which isn't available on this platform" << std::endl;
+    return false;
+#endif
+}
+
+bool Context::InitGlew()
+{
+    // glewInit has to be done in the context
+    GLenum result = glewInit();
+#ifdef GLEW_ERROR_NO_GLX_DISPLAY
+    // GLX builds of GLEW load the GL entry points first and only then fail on the
+    // missing X display, which is fine for an EGL context
+    if (result == GLEW_ERROR_NO_GLX_DISPLAY && m_Type == ContextType::Headless)
+        result = GLEW_OK;
+#endif
+    if (result != GLEW_OK)
+    {
+        std::cout << "Error! " << glewGetErrorString(result) << std::endl;
+        return false;
+    }
+    return true;
+}
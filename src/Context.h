@@ -0,0 +1,50 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "FrameBuffer.h"
+
+struct GLFWwindow;
+
+enum class ContextType
+{
+	Window, Headless
+};
+
+// Owns the GL context and the surface we render into.
+// Window   - GLFW window + default framebuffer
+// Headless - EGL context without any surface (Mesa surfaceless / llvmpipe),
+//            rendering goes into an offscreen FrameBuffer bound at creation
+class Context
+{
+private:
+	ContextType m_Type;
+	unsigned int m_Width, m_Height;
+	GLFWwindow* m_Window;
+	// EGL handles, kept opaque so this header doesn't pull in EGL
+	void* m_Display;
+	void* m_Context;
+	void* m_Surface;
+	std::unique_ptr<FrameBuffer> m_FrameBuffer;
+	bool m_Valid;
+public:
+	// debug requests a debug context so KHR_debug output (GLDebugOutput) is fully populated
+	Context(ContextType type, unsigned int width, unsigned int height, const std::string& title, bool debug = false);
+	~Context();
+
+	bool ShouldClose() const;
+	void SwapBuffers();
+	void PollEvents();
+
+	inline bool IsValid() const { return m_Valid; }
+	inline ContextType GetType() const { return m_Type; }
+	inline unsigned int GetWidth() const { return m_Width; }
+	inline unsigned int GetHeight() const { return m_Height; }
+	// offscreen target, nullptr for window contexts
+	inline FrameBuffer* GetFrameBuffer() const { return m_FrameBuffer.get(); }
+private:
+	bool CreateWindowContext(const std::string& title, bool debug);
+	bool CreateHeadlessContext(bool debug);
+	bool InitGlew();
+};
@@ -0,0 +1,128 @@
+#include "DeletionQueue.h"
+
+#include <algorithm>
+
+#include "Renderer.h"
+
+std::mutex DeletionQueue::s_Mutex;
+std::vector<DeletionQueue::Object> DeletionQueue::s_Incoming;
+std::vector<DeletionQueue::Batch> DeletionQueue::s_Batches;
+unsigned long long DeletionQueue::s_Frame = 0;
+unsigned int DeletionQueue::s_FrameLatency = 2;
+
+void DeletionQueue::Enqueue(GLObjectType type, unsigned int id)
+{
+    if (id == 0)
+        return;
+
+    std::lock_guard<std::mutex> lock(s_Mutex);
+    s_Incoming.push_back({ type, id, nullptr, { 0, 0, 0, 0 } });
+}
+
+void DeletionQueue::EnqueueFree(BufferArena& arena, const BufferAllocation& allocation)
+{
+    if (allocation.buffer == 0)
+        return;
+
+    std::lock_guard<std::mutex> lock(s_Mutex);
+    s_Incoming.push_back({ GLObjectType::ArenaRange, 0, &arena, allocation });
+}
+
+void DeletionQueue::ForgetArena(const BufferArena& arena)
+{
+    auto forget = [&arena](const Object& object) { return object.type == GLObjectType::ArenaRange && object.arena == &arena; };
+
+    std::lock_guard<std::mutex> lock(s_Mutex);
+    s_Incoming.erase(std::remove_if(s_Incoming.begin(), s_Incoming.end(), forget), s_Incoming.end());
+    for (Batch& batch : s_Batches)
+        batch.objects.erase(std::remove_if(batch.objects.begin(), batch.objects.end(), forget), batch.objects.end());
+}
+
+void DeletionQueue::Delete(const std::vector<Object>& objects)
+{
+    for (const Object& object : objects)
+    {
+        // the cache is only touched here, on the GL thread, when the name really goes away
+        switch (object.type)
+        {
+        case GLObjectType::Buffer:
+            RenderState::OnDeleteBuffer(object.id);
+            GLCall(glDeleteBuffers(1, &object.id));
+            break;
+        case GLObjectType::VertexArray:
+            RenderState::OnDeleteVertexArray(object.id);
+            GLCall(glDeleteVertexArrays(1, &object.id));
+            break;
+        case GLObjectType::Program:
+            RenderState::OnDeleteProgram(object.id);
+            GLCall(glDeleteProgram(object.id));
+            break;
+        case GLObjectType::Shader:
+            GLCall(glDeleteShader(object.id));
+            break;
+        case GLObjectType::ArenaRange:
+            object.arena->Free(object.allocation);
+            break;
+        }
+    }
+}
+
+void DeletionQueue::EndFrame()
+{
+    std::lock_guard<std::mutex> lock(s_Mutex);
+    Batch batch;
+    batch.objects.swap(s_Incoming);
+    if (!batch.objects.empty())
+    {
+        // everything submitted so far may still use these objects
+        GLCall(batch.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+        batch.frame = s_Frame;
+        s_Batches.push_back(std::move(batch));
+    }
+    s_Frame++;
+
+    // batches are in submission order, so stop at the first one that isn't done yet
+    size_t done = 0;
+    for (; done < s_Batches.size(); done++)
+    {
+        Batch& pending = s_Batches[done];
+        if (s_Frame - pending.frame < s_FrameLatency)
+            break;
+
+        GLCall(GLenum status = glClientWaitSync((GLsync)pending.fence, 0, 0));
+        if (status == GL_TIMEOUT_EXPIRED)
+            break;
+
+        GLCall(glDeleteSync((GLsync)pending.fence));
+        Delete(pending.objects);
+    }
+    s_Batches.erase(s_Batches.begin(), s_Batches.begin() + done);
+}
+
+void DeletionQueue::Flush()
+{
+    std::lock_guard<std::mutex> lock(s_Mutex);
+    for (Batch& batch : s_Batches)
+    {
+        GLCall(glDeleteSync((GLsync)batch.fence));
+        Delete(batch.objects);
+    }
+    s_Batches.clear();
+
+    Delete(s_Incoming);
+    s_Incoming.clear();
+}
+
+void DeletionQueue::SetFrameLatency(unsigned int frames)
+{
+    s_FrameLatency = frames;
+}
+
+unsigned int DeletionQueue::GetPendingCount()
+{
+    std::lock_guard<std::mutex> lock(s_Mutex);
+    unsigned int count = 0;
+    for (const Batch& batch : s_Batches)
+        count += (unsigned int)batch.objects.size();
+    return count + (unsigned int)s_Incoming.size();
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <mutex>
+#include <vector>
+
+#include "BufferArena.h"
+
+enum class GLObjectType
+{
+	Buffer, VertexArray, Program, Shader,
+	// a BufferArena range, handed back to its arena instead of deleted
+	ArenaRange
+};
+
+// Deferred glDelete* for the resource wrappers. Destructors only enqueue the name, which is
+// safe from any thread and never stalls on objects the GPU is still using. The GL thread
+// frees a frame's batch once it is at least the frame latency old and its fence has
+// signaled (Renderer::EndFrame calls EndFrame). Flush deletes everything right away,
+// Context does that before it destroys the GL context.
+class DeletionQueue
+{
+private:
+	struct Object
+	{
+		GLObjectType type;
+		unsigned int id;
+		// ArenaRange only
+		BufferArena* arena;
+		BufferAllocation allocation;
+	};
+
+	struct Batch
+	{
+		std::vector<Object> objects;
+		// GLsync, void* keeps GL headers out of here
+		void* fence;
+		unsigned long long frame;
+	};
+
+	// guards s_Incoming and s_Batches (ForgetArena may come from any thread)
+	static std::mutex s_Mutex;
+	// enqueued since the last EndFrame
+	static std::vector<Object> s_Incoming;
+	static std::vector<Batch> s_Batches;
+	static unsigned long long s_Frame;
+	static unsigned int s_FrameLatency;
+
+	static void Delete(const std::vector<Object>& objects);
+public:
+	// any thread. id 0 is ignored.
+	static void Enqueue(GLObjectType type, unsigned int id);
+	// any thread. The range goes back to the arena's free lists on the GL thread once the GPU is
+	// done with it, so it can't be handed out again while draws still read it.
+	static void EnqueueFree(BufferArena& arena, const BufferAllocation& allocation);
+	// drops pending frees of an arena that is going away (its buffers are deleted anyway)
+	static void ForgetArena(const BufferArena& arena);
+
+	// GL thread, once per frame
+	static void EndFrame();
+	// GL thread, deletes everything pending without waiting for the GPU (GL defers it internally)
+	static void Flush();
+
+	// frames a batch is kept at least, on top of waiting for its fence (default 2)
+	static void SetFrameLatency(unsigned int frames);
+	// objects still waiting to be deleted, GL thread
+	static unsigned int GetPendingCount();
+};
@@ -0,0 +1,55 @@
+#include "FrameBuffer.h"
+
+#include <iostream>
+
+#include "Renderer.h"
+
+FrameBuffer::FrameBuffer(unsigned int width, unsigned int height)
+    : m_RendererID(0), m_ColorAttachment(0), m_DepthAttachment(0), m_Width(width), m_Height(height)
+{
+    GLCall(glGenFramebuffers(1, &m_RendererID));
+    GLCall(glBindFramebuffer(GL_FRAMEBUFFER, m_RendererID));
+
+    GLCall(glGenRenderbuffers(1, &m_ColorAttachment));
+    GLCall(glBindRenderbuffer(GL_RENDERBUFFER, m_ColorAttachment));
+    GLCall(glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height));
+    GLCall(glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_ColorAttachment));
+
+    GLCall(glGenRenderbuffers(1, &m_DepthAttachment));
+    GLCall(glBindRenderbuffer(GL_RENDERBUFFER, m_DepthAttachment));
+    GLCall(glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height));
+    GLCall(glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_DepthAttachment));
+
+    GLCall(GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER));
+    if (status != GL_FRAMEBUFFER_COMPLETE)
+        std::cout << "Framebuffer is incomplete (" << status << ")" << std::endl;
+
+    GLCall(glBindRenderbuffer(GL_RENDERBUFFER, 0));
+    GLCall(glViewport(0, 0, width, height));
+}
+
+FrameBuffer::~FrameBuffer()
+{
+    GLCall(glDeleteRenderbuffers(1, &m_DepthAttachment));
+    GLCall(glDeleteRenderbuffers(1, &m_ColorAttachment));
+    GLCall(glDeleteFramebuffers(1, &m_RendererID));
+}
+
+void FrameBuffer::Bind() const
+{
+    GLCall(glBindFramebuffer(GL_FRAMEBUFFER, m_RendererID));
+}
+
+void FrameBuffer::Unbind() const
+{
+    GLCall(glBindFramebuffer(GL_FRAMEBUFFER, 0));
+}
+
+std::vector<unsigned char> FrameBuffer::ReadPixels() const
+{
+    std::vector<unsigned char> pixels((size_t)m_Width * m_Height * 4);
+    GLCall(glBindFramebuffer(GL_READ_FRAMEBUFFER, m_RendererID));
+    GLCall(glPixelStorei(GL_PACK_ALIGNMENT, 1));
+    GLCall(glReadPixels(0, 0, m_Width, m_Height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data()));
+    return pixels;
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <vector>
+
+// offscreen render target (color + depth/stencil renderbuffers)
+class FrameBuffer
+{
+private:
+	unsigned int m_RendererID;
+	unsigned int m_ColorAttachment;
+	unsigned int m_DepthAttachment;
+	unsigned int m_Width, m_Height;
+public:
+	FrameBuffer(unsigned int width, unsigned int height);
+	~FrameBuffer();
+
+	void Bind() const;
+	void Unbind() const;
+
+	// read back the color attachment as tightly packed RGBA8, bottom row first
+	std::vector<unsigned char> ReadPixels() const;
+
+	inline unsigned int GetWidth() const { return m_Width; }
+	inline unsigned int GetHeight() const { return m_Height; }
+};
@@ -0,0 +1,305 @@
+#include "GLDebug.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <unordered_map>
+
+#include "Renderer.h"
+
+static const char* SourceToString(GLenum source)
+{
+    switch (source)
+    {
+    case GL_DEBUG_SOURCE_API:             return "API";
+    case GL_DEBUG_SOURCE_WINDOW_SYSTEM:   return "WINDOW SYSTEM";
+    case GL_DEBUG_SOURCE_SHADER_COMPILER: return "SHADER COMPILER";
+    case GL_DEBUG_SOURCE_THIRD_PARTY:     return "THIRD PARTY";
+    case GL_DEBUG_SOURCE_APPLICATION:     return "APPLICATION";
+    }
+    return "OTHER";
+}
+
+static const char* TypeToString(GLenum type)
+{
+    switch (type)
+    {
+    case GL_DEBUG_TYPE_ERROR:               return "ERROR";
+    case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR: return "DEPRECATED";
+    case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR:  return "UNDEFINED BEHAVIOR";
+    case GL_DEBUG_TYPE_PORTABILITY:         return "PORTABILITY";
+    case GL_DEBUG_TYPE_PERFORMANCE:         return "PERFORMANCE";
+    case GL_DEBUG_TYPE_MARKER:              return "MARKER";
+    }
+    return "OTHER";
+}
+
+static GLDebugSeverity ToSeverity(GLenum severity)
+{
+    switch (severity)
+    {
+    case GL_DEBUG_SEVERITY_HIGH:   return GLDebugSeverity::High;
+    case GL_DEBUG_SEVERITY_MEDIUM: return GLDebugSeverity::Medium;
+    case GL_DEBUG_SEVERITY_LOW:    return GLDebugSeverity::Low;
+    }
+    return GLDebugSeverity::Notification;
+}
+
+static const char* SeverityToString(GLDebugSeverity severity)
+{
+    switch (severity)
+    {
+    case GLDebugSeverity::High:   return "HIGH";
+    case GLDebugSeverity::Medium: return "MEDIUM";
+    case GLDebugSeverity::Low:    return "LOW";
+    default:                      return "NOTIFICATION";
+    }
+}
+
+// Bounded multi-producer/single-consumer ring (Vyukov). With asynchronous debug
+// output the driver may call us from several of its own threads at once.
+struct DebugMessage
+{
+    std::atomic<size_t> sequence;
+    GLenum source;
+    GLenum type;
+    GLuint id;
+    GLDebugSeverity severity;
+    char text[256];
+};
+
+class DebugMessageRing
+{
+private:
+    static constexpr size_t s_Capacity = 1024; // power of two
+    DebugMessage m_Messages[s_Capacity];
+    std::atomic<size_t> m_EnqueuePos;
+    size_t m_DequeuePos;
+    std::atomic<unsigned long long> m_Dropped;
+public:
+    DebugMessageRing()
+        : m_EnqueuePos(0), m_DequeuePos(0), m_Dropped(0)
+    {
+        for (size_t i = 0; i < s_Capacity; i++)
+            m_Messages[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    // producer side, never blocks or allocates
+    bool Push(GLenum source, GLenum type, GLuint id, GLDebugSeverity severity, const char* text, size_t length)
+    {
+        DebugMessage* message;
+        size_t pos = m_EnqueuePos.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            message = &m_Messages[pos & (s_Capacity - 1)];
+            size_t sequence = message->sequence.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+            if (diff == 0)
+            {
+                if (m_EnqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (diff < 0)
+            {
+                m_Dropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            else
+            {
+                pos = m_EnqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+
+        message->source = source;
+        message->type = type;
+        message->id = id;
+        message->severity = severity;
+        if (length >= sizeof(message->text))
+            length = sizeof(message->text) - 1;
+        memcpy(message->text, text, length);
+        message->text[length] = '\0';
+        message->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    unsigned long long GetDroppedCount() const { return m_Dropped.load(std::memory_order_relaxed); }
+
+    // consumer side, only ever called from the logger thread
+    template<typename F>
+    size_t Drain(F&& f)
+    {
+        size_t count = 0;
+        for (;;)
+        {
+            DebugMessage& message = m_Messages[m_DequeuePos & (s_Capacity - 1)];
+            if (message.sequence.load(std::memory_order_acquire) != m_DequeuePos + 1)
+                return count;
+
+            f(message);
+            message.sequence.store(m_DequeuePos + s_Capacity, std::memory_order_release);
+            m_DequeuePos++;
+            count++;
+        }
+    }
+};
+
+class DebugLogger
+{
+private:
+    DebugMessageRing m_Ring;
+    std::thread m_Thread;
+    std::atomic<bool> m_Running;
+    // keyed by source/type/id, value is how often it was seen
+    std::unordered_map<uint64_t, unsigned int> m_Seen;
+    std::atomic<GLDebugSeverity> m_MinSeverity;
+public:
+    DebugLogger()
+        : m_Running(false), m_MinSeverity(GLDebugSeverity::Low) {}
+
+    ~DebugLogger()
+    {
+        Stop();
+    }
+
+    void Start()
+    {
+        if (m_Running.exchange(true))
+            return;
+        m_Thread = std::thread([this]() { Run(); });
+    }
+
+    void Stop()
+    {
+        if (!m_Running.exchange(false))
+            return;
+        m_Thread.join();
+
+        for (const auto& seen : m_Seen)
+        {
+            if (seen.second > 1)
+                std::cout << "[OpenGL Debug] id " << (seen.first & 0xFFFFFFFF) << " repeated " << seen.second << " times\n";
+        }
+        if (unsigned long long dropped = m_Ring.GetDroppedCount())
+            std::cout << "[OpenGL Debug] " << dropped << " messages dropped\n";
+        std::cout.flush();
+        m_Seen.clear();
+    }
+
+    bool IsRunning() const { return m_Running.load(std::memory_order_relaxed); }
+
+    // read from the driver callback, any thread
+    GLDebugSeverity GetMinSeverity() const { return m_MinSeverity.load(std::memory_order_relaxed); }
+    void SetMinSeverity(GLDebugSeverity minSeverity) { m_MinSeverity.store(minSeverity, std::memory_order_relaxed); }
+
+    DebugMessageRing& GetRing() { return m_Ring; }
+private:
+    void Run()
+    {
+        while (m_Running.load(std::memory_order_relaxed))
+        {
+            if (Flush() == 0)
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+        Flush();
+    }
+
+    size_t Flush()
+    {
+        size_t count = m_Ring.Drain([this](const DebugMessage& message)
+        {
+            uint64_t key = ((uint64_t)(message.source & 0xFFFF) << 48) | ((uint64_t)(message.type & 0xFFFF) << 32) | message.id;
+            if (m_Seen[key]++ > 0)
+                return;
+
+            std::cout << "[OpenGL Debug] (" << SeverityToString(message.severity) << ", " << SourceToString(message.source)
+                << " " << TypeToString(message.type) << ", id " << message.id << "): " << message.text << '\n';
+        });
+        if (count > 0)
+            std::cout.flush();
+        return count;
+    }
+};
+
+static DebugLogger s_DebugLogger;
+// what Enable switched off, Disable puts it back
+static GLErrorPolicy s_PreviousPolicy = GLErrorPolicy::PerCall;
+
+static void GLAPIENTRY DebugCallback(GLenum source, GLenum type, GLuint id, GLenum severity,
+    GLsizei length, const GLchar* message, const void* userParam)
+{
+    GLDebugSeverity level = ToSeverity(severity);
+    if (level < s_DebugLogger.GetMinSeverity())
+        return;
+
+    size_t size = length >= 0 ? (size_t)length : strlen(message);
+    s_DebugLogger.GetRing().Push(source, type, id, level, message, size);
+}
+
+bool GLDebugOutput::Enable(GLDebugSeverity minSeverity, bool synchronous)
+{
+    if (!GLEW_VERSION_4_3 && !GLEW_KHR_debug)
+    {
+        std::cout << "KHR_debug not supported, keeping glGetError checks" << std::endl;
+        return false;
+    }
+
+    SetMinSeverity(minSeverity);
+    if (!s_DebugLogger.IsRunning())
+        s_PreviousPolicy = GLGetErrorPolicy();
+    s_DebugLogger.Start();
+
+    GLCall(glEnable(GL_DEBUG_OUTPUT));
+    if (synchronous)
+    {
+        GLCall(glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS));
+    }
+    else
+    {
+        GLCall(glDisable(GL_DEBUG_OUTPUT_SYNCHRONOUS));
+    }
+    GLCall(glDebugMessageCallback(DebugCallback, nullptr));
+
+    // errors now arrive through the callback, stop polling for them
+    GLSetErrorPolicy(GLErrorPolicy::None);
+    return true;
+}
+
+void GLDebugOutput::Disable()
+{
+    if (!s_DebugLogger.IsRunning())
+        return;
+
+    glDebugMessageCallback(nullptr, nullptr);
+    glDisable(GL_DEBUG_OUTPUT);
+    s_DebugLogger.Stop();
+    GLSetErrorPolicy(s_PreviousPolicy);
+}
+
+void GLDebugOutput::SetMinSeverity(GLDebugSeverity minSeverity)
+{
+    s_DebugLogger.SetMinSeverity(minSeverity);
+
+    // let the driver skip formatting what we would throw away anyway
+    if (GLEW_VERSION_4_3 || GLEW_KHR_debug)
+    {
+        const GLenum severities[] = { GL_DEBUG_SEVERITY_NOTIFICATION, GL_DEBUG_SEVERITY_LOW, GL_DEBUG_SEVERITY_MEDIUM, GL_DEBUG_SEVERITY_HIGH };
+        for (int i = 0; i < 4; i++)
+        {
+            GLboolean enabled = (GLDebugSeverity)i >= minSeverity ? GL_TRUE : GL_FALSE;
+            GLCall(glDebugMessageControl(GL_DONT_CARE, GL_DONT_CARE, severities[i], 0, nullptr, enabled));
+        }
+    }
+}
+
+bool GLDebugOutput::IsEnabled()
+{
+    return s_DebugLogger.IsRunning();
+}
+
+unsigned long long GLDebugOutput::GetDroppedCount()
+{
+    return s_DebugLogger.GetRing().GetDroppedCount();
+}
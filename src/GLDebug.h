@@ -0,0 +1,27 @@
+#pragma once
+
+// ordered so messages can be filtered with >=
+enum class GLDebugSeverity
+{
+	Notification = 0, Low = 1, Medium = 2, High = 3
+};
+
+// KHR_debug message sink, an alternative to polling glGetError in GLCall.
+// The driver callback only copies the message into a lock-free ring buffer;
+// a background thread formats and prints it, and repeats of the same message
+// id are counted instead of printed again.
+class GLDebugOutput
+{
+public:
+	// needs a current context with GL 4.3 or KHR_debug (ideally a debug context).
+	// switches the GLCall error policy off since the callback replaces it.
+	static bool Enable(GLDebugSeverity minSeverity = GLDebugSeverity::Low, bool synchronous = false);
+	// call while the context is still current. Restores the GLCall error policy Enable replaced
+	static void Disable();
+
+	static void SetMinSeverity(GLDebugSeverity minSeverity);
+	static bool IsEnabled();
+
+	// messages lost because the ring buffer was full
+	static unsigned long long GetDroppedCount();
+};
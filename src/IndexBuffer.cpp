@@ -1,30 +1,155 @@
 #include "IndexBuffer.h"
 
+#include <vector>
+
 #include "Renderer.h"
+#include "DeletionQueue.h"
+
+// smallest index type the data fits in, narrowed copy goes to storage
+static unsigned int NarrowIndices(const unsigned int* data, unsigned int count, bool allowBytes, std::vector<unsigned char>& storage)
+{
+    unsigned int maxIndex = 0;
+    for (unsigned int i = 0; i < count; i++)
+        maxIndex = data[i] > maxIndex ? data[i] : maxIndex;
+
+    if (allowBytes && maxIndex <= 0xFF)
+    {
+        storage.resize(count);
+        for (unsigned int i = 0; i < count; i++)
+            storage[i] = (unsigned char)data[i];
+        return GL_UNSIGNED_BYTE;
+    }
+    if (maxIndex <= 0xFFFF)
+    {
+        storage.resize(count * sizeof(unsigned short));
+        unsigned short* narrow = (unsigned short*)storage.data();
+        for (unsigned int i = 0; i < count; i++)
+            narrow[i] = (unsigned short)data[i];
+        return GL_UNSIGNED_SHORT;
+    }
+    return GL_UNSIGNED_INT;
+}
 
-IndexBuffer::IndexBuffer(const unsigned int* data, unsigned int count)
-	: m_Count(count)
+IndexBuffer::IndexBuffer(const unsigned int* data, unsigned int count, bool allowBytes)
 {
     // byte of array buffer index may differ among platforms
     // error handling
     ASSERT(sizeof(unsigned int) == sizeof(GLuint));
 
+    std::vector<unsigned char> narrow;
+    unsigned int type = data ? NarrowIndices(data, count, allowBytes, narrow) : GL_UNSIGNED_INT;
+    Create(nullptr, narrow.empty() ? (const void*)data : narrow.data(), count, type);
+}
+
+IndexBuffer::IndexBuffer(const unsigned short* data, unsigned int count)
+{
+    Create(nullptr, data, count, GL_UNSIGNED_SHORT);
+}
+
+IndexBuffer::IndexBuffer(const unsigned char* data, unsigned int count)
+{
+    Create(nullptr, data, count, GL_UNSIGNED_BYTE);
+}
+
+IndexBuffer::IndexBuffer(BufferArena& arena, const unsigned int* data, unsigned int count, bool allowBytes)
+{
+    std::vector<unsigned char> narrow;
+    unsigned int type = NarrowIndices(data, count, allowBytes, narrow);
+    Create(&arena, narrow.empty() ? (const void*)data : narrow.data(), count, type);
+}
+
+IndexBuffer::IndexBuffer(BufferArena& arena, const unsigned short* data, unsigned int count)
+{
+    Create(&arena, data, count, GL_UNSIGNED_SHORT);
+}
+
+void IndexBuffer::Create(BufferArena* arena, const void* data, unsigned int count, unsigned int type)
+{
+    m_Count = count;
+    m_Type = type;
+    m_Arena = arena;
+    unsigned int size = count * GetIndexSize();
+
+    if (arena)
+    {
+        // aligned to the index size so the offset is a whole number of indices
+        m_Allocation = arena->Allocate(size, GetIndexSize());
+        m_RendererID = m_Allocation.buffer;
+        arena->Upload(m_Allocation, data, size);
+        return;
+    }
+
+    m_Allocation = { 0, 0, 0, size };
+    if (Renderer::UseDirectStateAccess())
+    {
+        GLCall(glCreateBuffers(1, &m_RendererID));
+        if (size)
+        {
+            GLCall(glNamedBufferStorage(m_RendererID, size, data, 0));
+        }
+        return;
+    }
+
     GLCall(glGenBuffers(1, &m_RendererID));
-    GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_RendererID));
-    GLCall(glBufferData(GL_ELEMENT_ARRAY_BUFFER, count * sizeof(unsigned int), data, GL_STATIC_DRAW));
+    RenderState::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_RendererID);
+    GLCall(glBufferData(GL_ELEMENT_ARRAY_BUFFER, size, data, GL_STATIC_DRAW));
 }
 
 IndexBuffer::~IndexBuffer()
 {
-    GLCall(glDeleteBuffers(1, &m_RendererID));
+    Release();
+}
+
+IndexBuffer::IndexBuffer(IndexBuffer&& other) noexcept
+    : m_RendererID(other.m_RendererID), m_Count(other.m_Count), m_Type(other.m_Type),
+      m_Arena(other.m_Arena), m_Allocation(other.m_Allocation)
+{
+    other.m_RendererID = 0;
+    other.m_Count = 0;
+    other.m_Arena = nullptr;
+    other.m_Allocation = { 0, 0, 0, 0 };
+}
+
+IndexBuffer& IndexBuffer::operator=(IndexBuffer&& other) noexcept
+{
+    if (this != &other)
+    {
+        Release();
+        m_RendererID = other.m_RendererID;
+        m_Count = other.m_Count;
+        m_Type = other.m_Type;
+        m_Arena = other.m_Arena;
+        m_Allocation = other.m_Allocation;
+
+        other.m_RendererID = 0;
+        other.m_Count = 0;
+        other.m_Arena = nullptr;
+        other.m_Allocation = { 0, 0, 0, 0 };
+    }
+    return *this;
+}
+
+void IndexBuffer::Release()
+{
+    if (m_Arena)
+    {
+        // the range may still be read by queued draws, same as a buffer of its own
+        DeletionQueue::EnqueueFree(*m_Arena, m_Allocation);
+        m_Arena = nullptr;
+    }
+    else if (m_RendererID)
+    {
+        DeletionQueue::Enqueue(GLObjectType::Buffer, m_RendererID);
+    }
+    m_RendererID = 0;
 }
 
 void IndexBuffer::Bind() const
 {
-    GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_RendererID));
+    RenderState::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_RendererID);
 }
 
 void IndexBuffer::Unbind() const
 {
-    GLCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0));
+    RenderState::BindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 }
@@ -1,17 +1,59 @@
 #pragma once
 
+#include <GL/glew.h>
+
+#include "BufferArena.h"
+
+// part of an index buffer, for several meshes sharing one vertex/index buffer pair
+struct IndexRange
+{
+	unsigned int count;
+	unsigned int firstIndex;
+	// added to every index before fetching the vertex
+	int baseVertex;
+};
+
 class IndexBuffer
 {
 private:
 	unsigned int m_RendererID;
 	unsigned int m_Count;
+	// GL_UNSIGNED_BYTE, GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+	unsigned int m_Type;
+	// set when this is a view into a shared arena buffer
+	BufferArena* m_Arena;
+	BufferAllocation m_Allocation;
+
+	void Create(BufferArena* arena, const void* data, unsigned int count, unsigned int type);
+	void Release();
 public:
 	// count - vertex count
-	IndexBuffer(const unsigned int* data, unsigned int count);
+	// 32 bit indices are narrowed to 16 bit when the largest one fits. 8 bit only with allowBytes,
+	// a lot of hardware doesn't fetch byte indices natively and the driver converts them.
+	IndexBuffer(const unsigned int* data, unsigned int count, bool allowBytes = false);
+	IndexBuffer(const unsigned short* data, unsigned int count);
+	IndexBuffer(const unsigned char* data, unsigned int count);
+	// views into an arena block, no buffer object of their own
+	IndexBuffer(BufferArena& arena, const unsigned int* data, unsigned int count, bool allowBytes = false);
+	IndexBuffer(BufferArena& arena, const unsigned short* data, unsigned int count);
 	~IndexBuffer();
 
+	// move-only, see VertexBuffer
+	IndexBuffer(const IndexBuffer&) = delete;
+	IndexBuffer& operator=(const IndexBuffer&) = delete;
+	IndexBuffer(IndexBuffer&& other) noexcept;
+	IndexBuffer& operator=(IndexBuffer&& other) noexcept;
+
 	void Bind() const;
 	void Unbind() const;
 
+	inline unsigned int GetRendererID() const { return m_RendererID; }
 	inline unsigned int GetCount() const { return m_Count; }
+	inline unsigned int GetType() const { return m_Type; }
+	// bytes per index
+	inline unsigned int GetIndexSize() const { return m_Type == GL_UNSIGNED_INT ? 4 : m_Type == GL_UNSIGNED_SHORT ? 2 : 1; }
+	// ranges are relative to this buffer, Renderer adds GetFirstIndex() when drawing
+	inline IndexRange GetRange() const { return { m_Count, 0, 0 }; }
+	// where this buffer's indices start inside the GL buffer object (non-zero for arena views)
+	inline unsigned int GetFirstIndex() const { return m_Allocation.offset / GetIndexSize(); }
 };
\ No newline at end of file
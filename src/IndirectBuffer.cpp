@@ -0,0 +1,80 @@
+#include "IndirectBuffer.h"
+
+#include "Renderer.h"
+#include "DeletionQueue.h"
+
+static unsigned int CreateBuffer()
+{
+    unsigned int id;
+    if (Renderer::UseDirectStateAccess())
+    {
+        GLCall(glCreateBuffers(1, &id));
+    }
+    else
+    {
+        GLCall(glGenBuffers(1, &id));
+    }
+    return id;
+}
+
+IndirectBuffer::IndirectBuffer()
+    : m_RendererID(CreateBuffer())
+{
+}
+
+IndirectBuffer::IndirectBuffer(const DrawElementsIndirectCommand* commands, unsigned int count)
+    : m_RendererID(CreateBuffer())
+{
+    SetCommands(commands, count);
+}
+
+IndirectBuffer::~IndirectBuffer()
+{
+    DeletionQueue::Enqueue(GLObjectType::Buffer, m_RendererID);
+}
+
+IndirectBuffer::IndirectBuffer(IndirectBuffer&& other) noexcept
+    : m_RendererID(other.m_RendererID), m_Commands(std::move(other.m_Commands))
+{
+    other.m_RendererID = 0;
+}
+
+IndirectBuffer& IndirectBuffer::operator=(IndirectBuffer&& other) noexcept
+{
+    if (this != &other)
+    {
+        DeletionQueue::Enqueue(GLObjectType::Buffer, m_RendererID);
+        m_RendererID = other.m_RendererID;
+        m_Commands = std::move(other.m_Commands);
+        other.m_RendererID = 0;
+    }
+    return *this;
+}
+
+void IndirectBuffer::SetCommands(const DrawElementsIndirectCommand* commands, unsigned int count)
+{
+    m_Commands.assign(commands, commands + count);
+
+    if (!Renderer::SupportsMultiDrawIndirect())
+        return;
+
+    // mutable storage, every upload orphans the old commands
+    if (Renderer::UseDirectStateAccess())
+    {
+        GLCall(glNamedBufferData(m_RendererID, count * sizeof(DrawElementsIndirectCommand), commands, GL_STREAM_DRAW));
+        return;
+    }
+
+    Bind();
+    GLCall(glBufferData(GL_DRAW_INDIRECT_BUFFER, count * sizeof(DrawElementsIndirectCommand), commands, GL_STREAM_DRAW));
+}
+
+void IndirectBuffer::Bind() const
+{
+    RenderState::BindBuffer(GL_DRAW_INDIRECT_BUFFER, m_RendererID);
+}
+
+void IndirectBuffer::Unbind() const
+{
+    RenderState::BindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
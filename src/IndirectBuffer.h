@@ -0,0 +1,41 @@
+#pragma once
+
+#include <vector>
+
+// layout fixed by GL for glDraw*ElementsIndirect
+struct DrawElementsIndirectCommand
+{
+	unsigned int count;
+	unsigned int instanceCount;
+	unsigned int firstIndex;
+	int baseVertex;
+	unsigned int baseInstance;
+};
+
+// GL_DRAW_INDIRECT_BUFFER holding draw commands for Renderer::DrawIndirect
+class IndirectBuffer
+{
+private:
+	unsigned int m_RendererID;
+	// CPU copy, used to emulate the draws when multi-draw indirect isn't supported
+	std::vector<DrawElementsIndirectCommand> m_Commands;
+public:
+	IndirectBuffer();
+	IndirectBuffer(const DrawElementsIndirectCommand* commands, unsigned int count);
+	~IndirectBuffer();
+
+	// move-only, see VertexBuffer
+	IndirectBuffer(const IndirectBuffer&) = delete;
+	IndirectBuffer& operator=(const IndirectBuffer&) = delete;
+	IndirectBuffer(IndirectBuffer&& other) noexcept;
+	IndirectBuffer& operator=(IndirectBuffer&& other) noexcept;
+
+	// replace the contents, the old storage is orphaned so draws still reading it don't stall us
+	void SetCommands(const DrawElementsIndirectCommand* commands, unsigned int count);
+
+	void Bind() const;
+	void Unbind() const;
+
+	inline unsigned int GetCount() const { return (unsigned int)m_Commands.size(); }
+	inline const std::vector<DrawElementsIndirectCommand>& GetCommands() const { return m_Commands; }
+};
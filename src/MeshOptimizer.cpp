@@ -0,0 +1,515 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <string_view>
+#include <unordered_map>
+
+#include "Renderer.h"
+
+// vertex -> triangles that use it, in CSR form
+struct TriangleAdjacency
+{
+    std::vector<unsigned int> offsets;
+    std::vector<unsigned int> triangles;
+    std::vector<unsigned int> counts;
+
+    TriangleAdjacency(const std::vector<unsigned int>& indices, unsigned int vertexCount)
+        : offsets(vertexCount + 1, 0), triangles(indices.size()), counts(vertexCount, 0)
+    {
+        for (unsigned int index : indices)
+            counts[index]++;
+        for (unsigned int v = 0; v < vertexCount; v++)
+            offsets[v + 1] = offsets[v] + counts[v];
+
+        std::vector<unsigned int> fill(offsets.begin(), offsets.end() - 1);
+        for (size_t i = 0; i < indices.size(); i++)
+            triangles[fill[indices[i]]++] = (unsigned int)(i / 3);
+    }
+};
+
+VertexCacheStats MeshOptimizer::AnalyzeVertexCache(const std::vector<unsigned int>& indices, unsigned int vertexCount, unsigned int cacheSize)
+{
+    VertexCacheStats stats = { vertexCount, (unsigned int)(indices.size() / 3), 0, 0.0f, 0.0f };
+
+    // FIFO: a vertex is still cached if fewer than cacheSize misses happened since it was loaded
+    std::vector<unsigned int> loadedAt(vertexCount, 0);
+    std::vector<bool> referenced(vertexCount, false);
+    unsigned int referencedCount = 0;
+    for (unsigned int index : indices)
+    {
+        ASSERT(index < vertexCount);
+        if (!referenced[index])
+        {
+            referenced[index] = true;
+            referencedCount++;
+        }
+        if (stats.transformedVertices - loadedAt[index] >= cacheSize || loadedAt[index] == 0)
+        {
+            stats.transformedVertices++;
+            loadedAt[index] = stats.transformedVertices;
+        }
+    }
+
+    if (stats.triangleCount)
+        stats.acmr = (float)stats.transformedVertices / stats.triangleCount;
+    if (referencedCount)
+        stats.atvr = (float)stats.transformedVertices / referencedCount;
+    return stats;
+}
+
+unsigned int MeshOptimizer::WeldVertices(std::vector<unsigned char>& vertices, unsigned int stride, std::vector<unsigned int>& indices)
+{
+    const unsigned int vertexCount = (unsigned int)(vertices.size() / stride);
+
+    // keys point into the input array, which stays untouched until the end
+    std::unordered_map<std::string_view, unsigned int> unique;
+    unique.reserve(vertexCount);
+    std::vector<unsigned int> remap(vertexCount);
+    std::vector<unsigned char> welded;
+    welded.reserve(vertices.size());
+    for (unsigned int v = 0; v < vertexCount; v++)
+    {
+        std::string_view key((const char*)&vertices[(size_t)v * stride], stride);
+        auto result = unique.emplace(key, (unsigned int)(welded.size() / stride));
+        if (result.second)
+            welded.insert(welded.end(), vertices.begin() + (size_t)v * stride, vertices.begin() + (size_t)(v + 1) * stride);
+        remap[v] = result.first->second;
+    }
+
+    for (unsigned int& index : indices)
+        index = remap[index];
+    vertices.swap(welded);
+    return (unsigned int)(vertices.size() / stride);
+}
+
+// Forsyth, "Linear-Speed Vertex Cache Optimisation"
+static const unsigned int s_ForsythCacheSize = 32;
+static const unsigned int s_ForsythMaxValence = 64;
+
+static float ForsythVertexScore(int cachePosition, unsigned int liveTriangles)
+{
+    if (liveTriangles == 0)
+        return -1.0f;
+
+    float score = 0.0f;
+    if (cachePosition >= 0)
+    {
+        // the last triangle's vertices get a fixed score so the next triangle doesn't just reuse them
+        if (cachePosition < 3)
+            score = 0.75f;
+        else
+            score = std::pow(1.0f - (float)(cachePosition - 3) / (s_ForsythCacheSize - 3), 1.5f);
+    }
+    // favour finishing off vertices with few triangles left
+    score += 2.0f / std::sqrt((float)liveTriangles);
+    return score;
+}
+
+void MeshOptimizer::OptimizeVertexCache(std::vector<unsigned int>& indices, unsigned int vertexCount)
+{
+    const unsigned int triangleCount = (unsigned int)(indices.size() / 3);
+    if (triangleCount == 0)
+        return;
+
+    TriangleAdjacency adjacency(indices, vertexCount);
+    std::vector<unsigned int>& live = adjacency.counts;
+
+    // score lookup, [cache position + 1][live triangles]
+    float scoreTable[s_ForsythCacheSize + 1][s_ForsythMaxValence];
+    for (unsigned int position = 0; position <= s_ForsythCacheSize; position++)
+        for (unsigned int valence = 0; valence < s_ForsythMaxValence; valence++)
+            scoreTable[position][valence] = ForsythVertexScore((int)position - 1, valence);
+    auto vertexScore = [&](int cachePosition, unsigned int liveTriangles)
+    {
+        if (liveTriangles >= s_ForsythMaxValence)
+            return ForsythVertexScore(cachePosition, liveTriangles);
+        return scoreTable[cachePosition + 1][liveTriangles];
+    };
+
+    std::vector<int> cachePosition(vertexCount, -1);
+    std::vector<float> vertexScores(vertexCount);
+    for (unsigned int v = 0; v < vertexCount; v++)
+        vertexScores[v] = vertexScore(-1, live[v]);
+
+    std::vector<float> triangleScores(triangleCount);
+    for (unsigned int t = 0; t < triangleCount; t++)
+        triangleScores[t] = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+
+    std::vector<bool> emitted(triangleCount, false);
+    std::vector<unsigned int> result;
+    result.reserve(indices.size());
+
+    // cache of the last pass plus room for the 3 new vertices
+    unsigned int cache[s_ForsythCacheSize + 3];
+    unsigned int cacheCount = 0;
+    unsigned int newCache[s_ForsythCacheSize + 3];
+
+    unsigned int best = 0;
+    float bestScore = triangleScores[0];
+    for (unsigned int t = 1; t < triangleCount; t++)
+    {
+        if (triangleScores[t] > bestScore)
+        {
+            best = t;
+            bestScore = triangleScores[t];
+        }
+    }
+
+    // fallback scan when no cached vertex has triangles left, input order is as good as any
+    unsigned int cursor = 0;
+    for (unsigned int emittedCount = 0; emittedCount < triangleCount; emittedCount++)
+    {
+        if (bestScore < 0.0f)
+        {
+            while (emitted[cursor])
+                cursor++;
+            best = cursor;
+        }
+
+        const unsigned int* triangle = &indices[best * 3];
+        result.insert(result.end(), triangle, triangle + 3);
+        emitted[best] = true;
+
+        // take the triangle out of its vertices' live lists
+        for (int k = 0; k < 3; k++)
+        {
+            unsigned int v = triangle[k];
+            unsigned int* begin = &adjacency.triangles[adjacency.offsets[v]];
+            unsigned int* end = begin + live[v];
+            std::iter_swap(std::find(begin, end, best), end - 1);
+            live[v]--;
+        }
+
+        // new cache: the triangle's vertices first, then the old entries
+        unsigned int newCount = 0;
+        for (int k = 0; k < 3; k++)
+            newCache[newCount++] = triangle[k];
+        for (unsigned int i = 0; i < cacheCount; i++)
+        {
+            unsigned int v = cache[i];
+            if (v != triangle[0] && v != triangle[1] && v != triangle[2])
+                newCache[newCount++] = v;
+        }
+
+        // rescore everything that was touched, including the vertices falling out
+        for (unsigned int i = 0; i < newCount; i++)
+        {
+            unsigned int v = newCache[i];
+            cachePosition[v] = i < s_ForsythCacheSize ? (int)i : -1;
+            vertexScores[v] = vertexScore(cachePosition[v], live[v]);
+        }
+
+        best = 0;
+        bestScore = -1.0f;
+        for (unsigned int i = 0; i < newCount; i++)
+        {
+            unsigned int v = newCache[i];
+            const unsigned int* triangles = &adjacency.triangles[adjacency.offsets[v]];
+            for (unsigned int j = 0; j < live[v]; j++)
+            {
+                unsigned int t = triangles[j];
+                float score = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+                triangleScores[t] = score;
+                if (score > bestScore)
+                {
+                    best = t;
+                    bestScore = score;
+                }
+            }
+        }
+
+        cacheCount = std::min(newCount, s_ForsythCacheSize);
+        std::copy(newCache, newCache + cacheCount, cache);
+    }
+
+    indices.swap(result);
+}
+
+// Sander, Nehab, Barczak, "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw"
+void MeshOptimizer::OptimizeVertexCacheTipsify(std::vector<unsigned int>& indices, unsigned int vertexCount, unsigned int cacheSize)
+{
+    const unsigned int triangleCount = (unsigned int)(indices.size() / 3);
+    if (triangleCount == 0)
+        return;
+
+    TriangleAdjacency adjacency(indices, vertexCount);
+    std::vector<unsigned int>& live = adjacency.counts;
+
+    std::vector<unsigned int> timestamps(vertexCount, 0);
+    unsigned int time = cacheSize + 1;
+    std::vector<bool> emitted(triangleCount, false);
+    std::vector<unsigned int> deadEnd;
+    std::vector<unsigned int> candidates;
+    std::vector<unsigned int> result;
+    result.reserve(indices.size());
+
+    unsigned int cursor = 0;
+    int fan = 0;
+    while (live[fan] == 0 && (unsigned int)fan + 1 < vertexCount)
+        fan++;
+
+    while (fan >= 0)
+    {
+        // emit every remaining triangle around the fanning vertex
+        candidates.clear();
+        for (unsigned int i = adjacency.offsets[fan]; i < adjacency.offsets[fan + 1]; i++)
+        {
+            unsigned int t = adjacency.triangles[i];
+            if (emitted[t])
+                continue;
+
+            for (int k = 0; k < 3; k++)
+            {
+                unsigned int v = indices[t * 3 + k];
+                result.push_back(v);
+                deadEnd.push_back(v);
+                candidates.push_back(v);
+                live[v]--;
+                if (time - timestamps[v] > cacheSize)
+                    timestamps[v] = time++;
+            }
+            emitted[t] = true;
+        }
+
+        // next fan: the candidate that stays in cache longest, if its fan still fits
+        fan = -1;
+        int bestPriority = -1;
+        for (unsigned int v : candidates)
+        {
+            if (live[v] == 0)
+                continue;
+
+            int priority = 0;
+            if (time - timestamps[v] + 2 * live[v] <= cacheSize)
+                priority = (int)(time - timestamps[v]);
+            if (priority > bestPriority)
+            {
+                bestPriority = priority;
+                fan = (int)v;
+            }
+        }
+
+        // dead end: recently used vertices first, then input order
+        while (fan < 0 && !deadEnd.empty())
+        {
+            unsigned int v = deadEnd.back();
+            deadEnd.pop_back();
+            if (live[v] > 0)
+                fan = (int)v;
+        }
+        while (fan < 0 && cursor < vertexCount)
+        {
+            if (live[cursor] > 0)
+                fan = (int)cursor;
+            cursor++;
+        }
+    }
+
+    indices.swap(result);
+}
+
+void MeshOptimizer::OptimizeOverdraw(std::vector<unsigned int>& indices, const std::vector<unsigned char>& vertices, unsigned int stride,
+    unsigned int positionComponents, float threshold, unsigned int cacheSize)
+{
+    ASSERT(positionComponents == 2 || positionComponents == 3);
+    const unsigned int vertexCount = (unsigned int)(vertices.size() / stride);
+    const unsigned int triangleCount = (unsigned int)(indices.size() / 3);
+    if (triangleCount == 0)
+        return;
+
+    // FIFO simulation shared by both passes. Restarting only moves base, so a cold cache
+    // doesn't cost a clear of the whole timestamp array.
+    std::vector<unsigned int> loadedAt(vertexCount, 0);
+    unsigned int base = 0;
+    unsigned int total = 0;
+    auto triangleMisses = [&](unsigned int t)
+    {
+        unsigned int misses = 0;
+        for (int k = 0; k < 3; k++)
+        {
+            unsigned int v = indices[t * 3 + k];
+            if (loadedAt[v] <= base || total - loadedAt[v] >= cacheSize)
+            {
+                loadedAt[v] = ++total;
+                misses++;
+            }
+        }
+        return misses;
+    };
+
+    // hard boundaries: triangles where the cache starts over (all three vertices missed).
+    // The first cluster always starts at 0, triangle 0 can miss fewer than 3 (degenerate ones)
+    std::vector<unsigned int> hard;
+    hard.push_back(0);
+    triangleMisses(0);
+    for (unsigned int t = 1; t < triangleCount; t++)
+    {
+        if (triangleMisses(t) == 3)
+            hard.push_back(t);
+    }
+    hard.push_back(triangleCount);
+
+    // soft boundaries: split hard clusters further as long as the ACMR stays within threshold
+    std::vector<unsigned int> clusters;
+    for (size_t h = 0; h + 1 < hard.size(); h++)
+    {
+        unsigned int begin = hard[h];
+        unsigned int end = hard[h + 1];
+
+        base = total;
+        for (unsigned int t = begin; t < end; t++)
+            triangleMisses(t);
+        float clusterAcmr = (float)(total - base) / (end - begin);
+
+        unsigned int start = begin;
+        base = total;
+        clusters.push_back(begin);
+        for (unsigned int t = begin; t < end; t++)
+        {
+            triangleMisses(t);
+            if (t + 1 < end && (float)(total - base) / (t - start + 1) <= clusterAcmr * threshold)
+            {
+                // the next cluster starts with a cold cache
+                start = t + 1;
+                base = total;
+                clusters.push_back(start);
+            }
+        }
+    }
+    clusters.push_back(triangleCount);
+
+    auto position = [&](unsigned int v, float* out)
+    {
+        const float* p = (const float*)&vertices[(size_t)v * stride];
+        out[0] = p[0];
+        out[1] = p[1];
+        out[2] = positionComponents == 3 ? p[2] : 0.0f;
+    };
+
+    // area weighted centroid and normal of every cluster
+    const size_t clusterCount = clusters.size() - 1;
+    std::vector<float> centroids(clusterCount * 3, 0.0f);
+    std::vector<float> normals(clusterCount * 3, 0.0f);
+    float meshCentroid[3] = { 0.0f, 0.0f, 0.0f };
+    float meshArea = 0.0f;
+    for (size_t c = 0; c < clusterCount; c++)
+    {
+        float area = 0.0f;
+        for (unsigned int t = clusters[c]; t < clusters[c + 1]; t++)
+        {
+            float a[3], b[3], d[3];
+            position(indices[t * 3], a);
+            position(indices[t * 3 + 1], b);
+            position(indices[t * 3 + 2], d);
+
+            float e0[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+            float e1[3] = { d[0] - a[0], d[1] - a[1], d[2] - a[2] };
+            float n[3] = { e0[1] * e1[2] - e0[2] * e1[1], e0[2] * e1[0] - e0[0] * e1[2], e0[0] * e1[1] - e0[1] * e1[0] };
+            float triangleArea = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+
+            for (int i = 0; i < 3; i++)
+            {
+                centroids[c * 3 + i] += (a[i] + b[i] + d[i]) / 3.0f * triangleArea;
+                normals[c * 3 + i] += n[i];
+                meshCentroid[i] += (a[i] + b[i] + d[i]) / 3.0f * triangleArea;
+            }
+            area += triangleArea;
+        }
+        meshArea += area;
+        if (area > 0.0f)
+            for (int i = 0; i < 3; i++)
+                centroids[c * 3 + i] /= area;
+    }
+    if (meshArea > 0.0f)
+        for (int i = 0; i < 3; i++)
+            meshCentroid[i] /= meshArea;
+
+    // clusters facing away from the mesh center go first
+    std::vector<float> sortKeys(clusterCount);
+    for (size_t c = 0; c < clusterCount; c++)
+    {
+        const float* n = &normals[c * 3];
+        float length = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        float key = 0.0f;
+        for (int i = 0; i < 3; i++)
+            key += (centroids[c * 3 + i] - meshCentroid[i]) * n[i];
+        sortKeys[c] = length > 0.0f ? key / length : 0.0f;
+    }
+
+    std::vector<unsigned int> order(clusterCount);
+    for (size_t c = 0; c < clusterCount; c++)
+        order[c] = (unsigned int)c;
+    std::stable_sort(order.begin(), order.end(), [&](unsigned int a, unsigned int b) { return sortKeys[a] > sortKeys[b]; });
+
+    std::vector<unsigned int> result;
+    result.reserve(indices.size());
+    for (unsigned int c : order)
+        result.insert(result.end(), indices.begin() + clusters[c] * 3, indices.begin() + clusters[c + 1] * 3);
+    // reordering only, every triangle has to come out again
+    ASSERT(result.size() == indices.size());
+    indices.swap(result);
+}
+
+unsigned int MeshOptimizer::OptimizeVertexFetch(std::vector<unsigned char>& vertices, unsigned int stride, std::vector<unsigned int>& indices)
+{
+    const unsigned int vertexCount = (unsigned int)(vertices.size() / stride);
+    const unsigned int unused = ~0u;
+
+    std::vector<unsigned int> remap(vertexCount, unused);
+    std::vector<unsigned char> reordered;
+    reordered.reserve(vertices.size());
+    unsigned int next = 0;
+    for (unsigned int& index : indices)
+    {
+        if (remap[index] == unused)
+        {
+            remap[index] = next++;
+            reordered.insert(reordered.end(), vertices.begin() + (size_t)index * stride, vertices.begin() + (size_t)(index + 1) * stride);
+        }
+        index = remap[index];
+    }
+
+    vertices.swap(reordered);
+    return next;
+}
+
+MeshOptimizeReport MeshOptimizer::Optimize(std::vector<unsigned char>& vertices, unsigned int stride, std::vector<unsigned int>& indices,
+    unsigned int positionComponents, VertexCacheMethod method, float overdrawThreshold)
+{
+    MeshOptimizeReport report;
+    report.cacheSize = s_DefaultCacheSize;
+    unsigned int vertexCount = (unsigned int)(vertices.size() / stride);
+    const size_t indexCount = indices.size();
+
+    // "before" is measured after welding, unwelded input always looks like ATVR 1
+    report.weldedVertices = vertexCount;
+    vertexCount = WeldVertices(vertices, stride, indices);
+    report.weldedVertices -= vertexCount;
+    report.before = AnalyzeVertexCache(indices, vertexCount);
+
+    if (method == VertexCacheMethod::Tipsify)
+        OptimizeVertexCacheTipsify(indices, vertexCount);
+    else
+        OptimizeVertexCache(indices, vertexCount);
+
+    if (positionComponents == 3)
+        OptimizeOverdraw(indices, vertices, stride, positionComponents, overdrawThreshold);
+
+    vertexCount = OptimizeVertexFetch(vertices, stride, indices);
+    // no pass may drop triangles, degenerate ones included
+    ASSERT(indices.size() == indexCount);
+    report.after = AnalyzeVertexCache(indices, vertexCount);
+    return report;
+}
+
+std::ostream& operator<<(std::ostream& stream, const MeshOptimizeReport& report)
+{
+    stream << report.before.triangleCount << " triangles, " << report.before.vertexCount + report.weldedVertices << " -> " << report.after.vertexCount
+        << " vertices (" << report.weldedVertices << " welded), FIFO " << report.cacheSize << "\n";
+    stream << "  ACMR " << report.before.acmr << " -> " << report.after.acmr << "\n";
+    stream << "  ATVR " << report.before.atvr << " -> " << report.after.atvr << "\n";
+    return stream;
+}
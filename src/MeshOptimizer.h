@@ -0,0 +1,70 @@
+#pragma once
+
+#include <ostream>
+#include <vector>
+
+// Offline mesh processing, run on the raw arrays before they go into a VertexBuffer/IndexBuffer.
+// Vertices are tightly packed with a fixed stride, positions are the first 2 or 3 floats.
+// Indices are triangle lists.
+
+// post-transform cache behaviour of an index buffer, simulated with a FIFO cache
+struct VertexCacheStats
+{
+	unsigned int vertexCount;
+	unsigned int triangleCount;
+	// cache misses, i.e. vertex shader invocations
+	unsigned int transformedVertices;
+	// average cache miss ratio, transformed vertices per triangle (0.5 is ideal for big grids, 3 is worst)
+	float acmr;
+	// average transform to vertex ratio, transformed vertices per referenced vertex (1 is ideal)
+	float atvr;
+};
+
+struct MeshOptimizeReport
+{
+	// before is measured after welding, in the original triangle order
+	VertexCacheStats before;
+	VertexCacheStats after;
+	unsigned int weldedVertices;
+	unsigned int cacheSize;
+};
+
+std::ostream& operator<<(std::ostream& stream, const MeshOptimizeReport& report);
+
+enum class VertexCacheMethod
+{
+	// Forsyth's linear-speed optimizer, scores vertices by LRU position and remaining valence
+	Forsyth,
+	// Sander et al. Tipsify, fans around vertices with a known FIFO cache size, faster
+	Tipsify
+};
+
+class MeshOptimizer
+{
+public:
+	// cache size the statistics and Tipsify assume, typical for post-transform caches
+	static const unsigned int s_DefaultCacheSize = 16;
+
+	// whole pipeline: weld, vertex cache order, overdraw cluster order, fetch remap. In place.
+	// positionComponents - 2 or 3, overdraw ordering only does something for 3D meshes
+	static MeshOptimizeReport Optimize(std::vector<unsigned char>& vertices, unsigned int stride, std::vector<unsigned int>& indices,
+		unsigned int positionComponents = 3, VertexCacheMethod method = VertexCacheMethod::Forsyth, float overdrawThreshold = 1.05f);
+
+	// merges byte-identical vertices, returns the new vertex count
+	static unsigned int WeldVertices(std::vector<unsigned char>& vertices, unsigned int stride, std::vector<unsigned int>& indices);
+
+	// reorders triangles for the post-transform cache
+	static void OptimizeVertexCache(std::vector<unsigned int>& indices, unsigned int vertexCount);
+	static void OptimizeVertexCacheTipsify(std::vector<unsigned int>& indices, unsigned int vertexCount, unsigned int cacheSize = s_DefaultCacheSize);
+
+	// splits a cache-optimized triangle order into clusters and sorts them outside-in so front
+	// surfaces tend to be drawn first. threshold - how much ACMR may grow (1.05 = 5%)
+	static void OptimizeOverdraw(std::vector<unsigned int>& indices, const std::vector<unsigned char>& vertices, unsigned int stride,
+		unsigned int positionComponents, float threshold = 1.05f, unsigned int cacheSize = s_DefaultCacheSize);
+
+	// renumbers vertices in order of first use so fetches walk memory linearly,
+	// drops unreferenced vertices, returns the new vertex count
+	static unsigned int OptimizeVertexFetch(std::vector<unsigned char>& vertices, unsigned int stride, std::vector<unsigned int>& indices);
+
+	static VertexCacheStats AnalyzeVertexCache(const std::vector<unsigned int>& indices, unsigned int vertexCount, unsigned int cacheSize = s_DefaultCacheSize);
+};
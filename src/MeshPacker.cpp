@@ -0,0 +1,19 @@
+#include "MeshPacker.h"
+
+#include <cstddef>
+
+MeshPacker::MeshPacker(unsigned int stride)
+    : m_Stride(stride)
+{
+}
+
+IndexRange MeshPacker::Add(const void* vertices, unsigned int vertexCount, const unsigned int* indices, unsigned int indexCount)
+{
+    IndexRange range = { indexCount, (unsigned int)m_Indices.size(), (int)GetVertexCount() };
+
+    const unsigned char* bytes = (const unsigned char*)vertices;
+    m_Vertices.insert(m_Vertices.end(), bytes, bytes + (size_t)vertexCount * m_Stride);
+    m_Indices.insert(m_Indices.end(), indices, indices + indexCount);
+
+    return range;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <vector>
+
+#include "IndexBuffer.h"
+
+// Packs many meshes into one shared vertex array and index array so they can live
+// in a single VertexBuffer/IndexBuffer and be drawn with Renderer::DrawRange or
+// one DrawIndirect call. Indices stay mesh-local, Add returns the base vertex.
+class MeshPacker
+{
+private:
+	unsigned int m_Stride;
+	std::vector<unsigned char> m_Vertices;
+	std::vector<unsigned int> m_Indices;
+public:
+	// stride - vertex size in bytes, same for every mesh
+	MeshPacker(unsigned int stride);
+
+	IndexRange Add(const void* vertices, unsigned int vertexCount, const unsigned int* indices, unsigned int indexCount);
+
+	inline const void* GetVertexData() const { return m_Vertices.data(); }
+	inline unsigned int GetVertexDataSize() const { return (unsigned int)m_Vertices.size(); }
+	inline unsigned int GetVertexCount() const { return (unsigned int)(m_Vertices.size() / m_Stride); }
+	inline const unsigned int* GetIndexData() const { return m_Indices.data(); }
+	inline unsigned int GetIndexCount() const { return (unsigned int)m_Indices.size(); }
+};
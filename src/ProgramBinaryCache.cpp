@@ -0,0 +1,193 @@
+#include "ProgramBinaryCache.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+#include "Renderer.h"
+
+std::string ProgramBinaryCache::s_Directory;
+unsigned int ProgramBinaryCache::s_Hits = 0;
+unsigned int ProgramBinaryCache::s_Misses = 0;
+
+// file layout: header, then the binary
+struct ProgramBinaryHeader
+{
+    char magic[4];
+    uint32_t version;
+    // the whole key again, the file name could in theory be anything
+    uint64_t key;
+    uint32_t format;
+    uint32_t length;
+};
+
+static const char s_Magic[4] = { 'K', 'L', 'P', 'B' };
+static const uint32_t s_FormatVersion = 1;
+
+static uint64_t Fnv1a(uint64_t hash, const void* data, size_t size)
+{
+    const unsigned char* bytes = (const unsigned char*)data;
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 0x100000001B3ull;
+    }
+    return hash;
+}
+
+static uint64_t HashString(uint64_t hash, std::string_view string)
+{
+    hash = Fnv1a(hash, string.data(), string.size());
+    // separator, so "ab" + "c" and "a" + "bc" differ
+    const unsigned char zero = 0;
+    return Fnv1a(hash, &zero, 1);
+}
+
+void ProgramBinaryCache::SetDirectory(const std::string& directory)
+{
+    s_Directory = directory;
+}
+
+bool ProgramBinaryCache::IsEnabled()
+{
+    if (s_Directory.empty() || !(GLEW_VERSION_4_1 || GLEW_ARB_get_program_binary))
+        return false;
+
+    GLint formats = 0;
+    GLCall(glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats));
+    return formats > 0;
+}
+
+uint64_t ProgramBinaryCache::MakeKey(std::initializer_list<std::string_view> sources)
+{
+    uint64_t hash = 0xCBF29CE484222325ull;
+    for (std::string_view source : sources)
+        hash = HashString(hash, source);
+
+    // binaries are only valid for the driver that made them
+    const GLenum strings[] = { GL_VENDOR, GL_RENDERER, GL_VERSION };
+    for (GLenum name : strings)
+    {
+        const char* value = (const char*)glGetString(name);
+        hash = HashString(hash, value ? value : "");
+    }
+    return hash;
+}
+
+bool ProgramBinaryCache::IsFormatSupported(unsigned int format)
+{
+    GLint count = 0;
+    GLCall(glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &count));
+    std::vector<GLint> formats(count);
+    if (count > 0)
+    {
+        GLCall(glGetIntegerv(GL_PROGRAM_BINARY_FORMATS, formats.data()));
+    }
+    return std::find(formats.begin(), formats.end(), (GLint)format) != formats.end();
+}
+
+std::string ProgramBinaryCache::GetPath(uint64_t key)
+{
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)key);
+    return (std::filesystem::path(s_Directory) / name).string();
+}
+
+unsigned int ProgramBinaryCache::Load(uint64_t key)
+{
+    if (!IsEnabled())
+        return 0;
+
+    const std::string path = GetPath(key);
+    std::ifstream file(path, std::ios::binary);
+    ProgramBinaryHeader header;
+    if (!file || !file.read((char*)&header, sizeof(header)))
+    {
+        s_Misses++;
+        return 0;
+    }
+
+    // the length has to match what's actually in the file, a corrupt one could ask for gigabytes
+    std::error_code error;
+    const uintmax_t fileSize = std::filesystem::file_size(path, error);
+
+    std::vector<char> binary;
+    bool valid = std::equal(s_Magic, s_Magic + 4, header.magic) && header.version == s_FormatVersion && header.key == key
+        && !error && fileSize == sizeof(header) + (uintmax_t)header.length;
+    // glProgramBinary raises GL_INVALID_ENUM for a format the driver dropped, treat it as a miss
+    valid = valid && IsFormatSupported(header.format);
+    if (valid)
+    {
+        binary.resize(header.length);
+        valid = (bool)file.read(binary.data(), header.length);
+    }
+    file.close();
+
+    unsigned int program = 0;
+    if (valid)
+    {
+        program = glCreateProgram();
+        GLCall(glProgramBinary(program, header.format, binary.data(), (GLsizei)header.length));
+        // drivers may refuse binaries from other versions even if the strings match
+        GLint linked = GL_FALSE;
+        GLCall(glGetProgramiv(program, GL_LINK_STATUS, &linked));
+        if (!linked)
+        {
+            GLCall(glDeleteProgram(program));
+            program = 0;
+        }
+    }
+
+    if (!program)
+    {
+        std::filesystem::remove(path, error);
+        s_Misses++;
+        return 0;
+    }
+
+    s_Hits++;
+    return program;
+}
+
+void ProgramBinaryCache::PrepareForStore(unsigned int program)
+{
+    if (IsEnabled())
+    {
+        GLCall(glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE));
+    }
+}
+
+void ProgramBinaryCache::Store(uint64_t key, unsigned int program)
+{
+    if (!IsEnabled())
+        return;
+
+    GLint length = 0;
+    GLCall(glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length));
+    if (length <= 0)
+        return;
+
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    GLCall(glGetProgramBinary(program, length, &length, &format, binary.data()));
+
+    std::error_code error;
+    std::filesystem::create_directories(s_Directory, error);
+
+    // write next to the final name and rename, so a crash or a second process never leaves half a file
+    const std::string path = GetPath(key);
+    const std::string temporary = path + ".tmp";
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        ProgramBinaryHeader header = { { s_Magic[0], s_Magic[1], s_Magic[2], s_Magic[3] }, s_FormatVersion, key, format, (uint32_t)length };
+        file.write((const char*)&header, sizeof(header));
+        file.write(binary.data(), length);
+        if (!file)
+            return;
+    }
+    std::filesystem::rename(temporary, path, error);
+    if (error)
+        std::filesystem::remove(temporary, error);
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+
+// On-disk cache of linked program binaries (glGetProgramBinary/glProgramBinary), one file per
+// program in the cache directory. The key hashes the final shader sources together with the GL
+// vendor, renderer and version strings, so a driver update or a changed shader simply misses.
+// Binaries the driver rejects are deleted and the caller compiles from source again.
+class ProgramBinaryCache
+{
+private:
+	static std::string s_Directory;
+	static unsigned int s_Hits;
+	static unsigned int s_Misses;
+
+	static std::string GetPath(uint64_t key);
+	static bool IsFormatSupported(unsigned int format);
+public:
+	// "" (the default) turns the cache off
+	static void SetDirectory(const std::string& directory);
+	// directory set and the driver can hand out program binaries (GL 4.1 / ARB_get_program_binary)
+	static bool IsEnabled();
+
+	static uint64_t MakeKey(std::initializer_list<std::string_view> sources);
+
+	// linked program or 0 on a miss
+	static unsigned int Load(uint64_t key);
+	// call before glLinkProgram, some drivers only keep the binary around when asked to
+	static void PrepareForStore(unsigned int program);
+	// program has to be linked successfully
+	static void Store(uint64_t key, unsigned int program);
+
+	inline static unsigned int GetHitCount() { return s_Hits; }
+	inline static unsigned int GetMissCount() { return s_Misses; }
+};
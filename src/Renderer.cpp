@@ -1,27 +1,396 @@
 #include "Renderer.h"
+#include "DeletionQueue.h"
+#include "ShaderHotReload.h"
 
+#include <cstdint>
 #include <iostream>
 
+static GLErrorPolicy s_GLErrorPolicy =
+    KLGL_GL_CHECK == KLGL_GL_CHECK_CALL ? GLErrorPolicy::PerCall :
+    KLGL_GL_CHECK == KLGL_GL_CHECK_FRAME ? GLErrorPolicy::PerFrame : GLErrorPolicy::None;
+
 void GLClearError()
 {
+    if (s_GLErrorPolicy != GLErrorPolicy::PerCall)
+        return;
+
     while (glGetError() != GL_NO_ERROR);
 }
 
 bool GLLogCall(const char* function, const char* file, int line)
 {
+    if (s_GLErrorPolicy != GLErrorPolicy::PerCall)
+    {
+        GLRecordCall(function, file, line);
+        return true;
+    }
+
+    // report every pending error, not just the first one
+    bool ok = true;
     while (GLenum error = glGetError())
     {
         std::cout << "[OpenGL Error] (" << error << "): " << function <<
-            " " << file << ":" << line << std::endl;
-        return false;
+            " " << file << ":" << line << '\n';
+        ok = false;
     }
-    return true;
+    if (!ok)
+        std::cout.flush();
+    return ok;
+}
+
+bool GLCheckFrame()
+{
+    if (s_GLErrorPolicy != GLErrorPolicy::PerFrame)
+        return true;
+
+    bool ok = true;
+    while (GLenum error = glGetError())
+    {
+        const GLCallSite& site = GLCallTracker::GetLastCall();
+        std::cout << "[OpenGL Error] (" << error << ") this frame, last call: "
+            << (site.function ? site.function : "?") << " "
+            << (site.file ? site.file : "?") << ":" << site.line << '\n';
+        ok = false;
+    }
+    if (!ok)
+        std::cout.flush();
+    return ok;
+}
+
+void GLSetErrorPolicy(GLErrorPolicy policy)
+{
+#if KLGL_GL_CHECK == KLGL_GL_CHECK_CALL
+    s_GLErrorPolicy = policy;
+#elif KLGL_GL_CHECK == KLGL_GL_CHECK_FRAME
+    // per-call checks are compiled out, so the best we can do is per frame
+    s_GLErrorPolicy = policy == GLErrorPolicy::None ? GLErrorPolicy::None : GLErrorPolicy::PerFrame;
+#else
+    (void)policy;
+#endif
+}
+
+GLErrorPolicy GLGetErrorPolicy()
+{
+    return s_GLErrorPolicy;
+}
+
+unsigned int RenderState::s_Program = RenderState::s_Unknown;
+unsigned int RenderState::s_VertexArray = RenderState::s_Unknown;
+unsigned int RenderState::s_ArrayBuffer = RenderState::s_Unknown;
+unsigned int RenderState::s_ElementBuffer = RenderState::s_Unknown;
+unsigned int RenderState::s_IndirectBuffer = RenderState::s_Unknown;
+RenderStats RenderState::s_Stats;
+
+void RenderState::UseProgram(unsigned int id)
+{
+    if (s_Program == id)
+    {
+        s_Stats.SkippedBinds++;
+        return;
+    }
+    GLCall(glUseProgram(id));
+    s_Program = id;
+    s_Stats.ProgramBinds++;
+}
+
+void RenderState::BindVertexArray(unsigned int id)
+{
+    if (s_VertexArray == id)
+    {
+        s_Stats.SkippedBinds++;
+        return;
+    }
+    GLCall(glBindVertexArray(id));
+    s_VertexArray = id;
+    // the element buffer binding is part of the VAO
+    s_ElementBuffer = s_Unknown;
+    s_Stats.VertexArrayBinds++;
+}
+
+void RenderState::BindBuffer(unsigned int target, unsigned int id)
+{
+    unsigned int* cached = nullptr;
+    if (target == GL_ARRAY_BUFFER)
+        cached = &s_ArrayBuffer;
+    else if (target == GL_ELEMENT_ARRAY_BUFFER)
+        cached = &s_ElementBuffer;
+    else if (target == GL_DRAW_INDIRECT_BUFFER)
+        cached = &s_IndirectBuffer;
+
+    if (cached && *cached == id)
+    {
+        s_Stats.SkippedBinds++;
+        return;
+    }
+    GLCall(glBindBuffer(target, id));
+    if (cached)
+        *cached = id;
+    s_Stats.BufferBinds++;
+}
+
+void RenderState::OnDeleteProgram(unsigned int id)
+{
+    // a deleted program stays in use until something else is bound, so we can't assume 0
+    if (s_Program == id)
+        s_Program = s_Unknown;
+}
+
+void RenderState::OnDeleteVertexArray(unsigned int id)
+{
+    if (s_VertexArray == id)
+    {
+        s_VertexArray = 0;
+        s_ElementBuffer = s_Unknown;
+    }
+}
+
+void RenderState::OnDeleteBuffer(unsigned int id)
+{
+    // deleting a bound buffer reverts the binding to 0
+    if (s_ArrayBuffer == id)
+        s_ArrayBuffer = 0;
+    if (s_ElementBuffer == id)
+        s_ElementBuffer = 0;
+    if (s_IndirectBuffer == id)
+        s_IndirectBuffer = 0;
+}
+
+void RenderState::Invalidate()
+{
+    s_Program = s_Unknown;
+    s_VertexArray = s_Unknown;
+    s_ArrayBuffer = s_Unknown;
+    s_ElementBuffer = s_Unknown;
+    s_IndirectBuffer = s_Unknown;
+}
+
+// byte offset of the first index, passed where GL expects a pointer
+static const void* IndexOffset(const IndexBuffer& ib, unsigned int firstIndex)
+{
+    return (const void*)(uintptr_t)(firstIndex * ib.GetIndexSize());
+}
+
+// firstIndex is relative to the buffer object, callers add ib.GetFirstIndex() themselves
+static void DrawElements(const IndexBuffer& ib, unsigned int count, unsigned int firstIndex, int baseVertex, unsigned int instanceCount)
+{
+    if (baseVertex == 0 && instanceCount == 1)
+    {
+        GLCall(glDrawElements(GL_TRIANGLES, count, ib.GetType(), IndexOffset(ib, firstIndex)));
+    }
+    else
+    {
+        GLCall(glDrawElementsInstancedBaseVertex(GL_TRIANGLES, count, ib.GetType(), IndexOffset(ib, firstIndex), instanceCount, baseVertex));
+    }
+}
+
+bool Renderer::SupportsMultiDrawIndirect()
+{
+    return GLEW_VERSION_4_3 || GLEW_ARB_multi_draw_indirect;
+}
+
+static bool s_DirectStateAccessEnabled = true;
+
+bool Renderer::UseDirectStateAccess()
+{
+    return s_DirectStateAccessEnabled &&
+        (GLEW_VERSION_4_5 || (GLEW_ARB_direct_state_access && VertexArray::SupportsAttribBinding()));
+}
+
+void Renderer::SetDirectStateAccessEnabled(bool enabled)
+{
+    s_DirectStateAccessEnabled = enabled;
+}
+
+static const ShaderProgramSource s_FallbackSource = {
+    "#version 330 core\n"
+    "layout(location = 0) in vec4 position;\n"
+    "void main() { gl_Position = position; }\n",
+    "#version 330 core\n"
+    "layout(location = 0) out vec4 color;\n"
+    "void main() { color = vec4(1.0, 0.0, 1.0, 1.0); }\n"
+};
+
+void Renderer::BindShader(const Shader& shader) const
+{
+    if (shader.IsReady())
+    {
+        shader.Bind();
+        return;
+    }
+
+    if (!m_FallbackShader)
+        m_FallbackShader = std::make_unique<Shader>(s_FallbackSource, "fallback");
+    // Bind waits, so the placeholder itself is never skipped
+    m_FallbackShader->Bind();
 }
 
 void Renderer::Draw(const VertexArray& va, const IndexBuffer& ib, const Shader& shader) const
 {
-    shader.Bind();
+    BindShader(shader);
+    va.Bind();
+    ib.Bind();
+    DrawElements(ib, ib.GetCount(), ib.GetFirstIndex(), 0, 1);
+    RenderState::GetStats().DrawCalls++;
+}
+
+void Renderer::DrawInstanced(const VertexArray& va, const IndexBuffer& ib, const Shader& shader, unsigned int instanceCount) const
+{
+    BindShader(shader);
     va.Bind();
     ib.Bind();
-    GLCall(glDrawElements(GL_TRIANGLES, ib.GetCount(), GL_UNSIGNED_INT, nullptr));
+    DrawElements(ib, ib.GetCount(), ib.GetFirstIndex(), 0, instanceCount);
+    RenderState::GetStats().DrawCalls++;
+}
+
+void Renderer::DrawRange(const VertexArray& va, const IndexBuffer& ib, const Shader& shader, const IndexRange& range, unsigned int instanceCount) const
+{
+    BindShader(shader);
+    va.Bind();
+    ib.Bind();
+    DrawElements(ib, range.count, ib.GetFirstIndex() + range.firstIndex, range.baseVertex, instanceCount);
+    RenderState::GetStats().DrawCalls++;
+}
+
+void Renderer::DrawIndirect(const VertexArray& va, const IndexBuffer& ib, const Shader& shader, const IndirectBuffer& commands, unsigned int drawCount, unsigned int firstCommand) const
+{
+    if (drawCount == 0)
+        return;
+
+    BindShader(shader);
+    va.Bind();
+    ib.Bind();
+
+    if (SupportsMultiDrawIndirect())
+    {
+        commands.Bind();
+        GLCall(glMultiDrawElementsIndirect(GL_TRIANGLES, ib.GetType(),
+            (const void*)(uintptr_t)(firstCommand * sizeof(DrawElementsIndirectCommand)), drawCount, 0));
+        RenderState::GetStats().DrawCalls++;
+        RenderState::GetStats().IndirectDraws += drawCount;
+        return;
+    }
+
+    // baseInstance is lost here, it needs GL 4.2 anyway
+    for (unsigned int i = firstCommand; i < firstCommand + drawCount; i++)
+    {
+        const DrawElementsIndirectCommand& command = commands.GetCommands()[i];
+        DrawElements(ib, command.count, command.firstIndex, command.baseVertex, command.instanceCount);
+    }
+    RenderState::GetStats().DrawCalls += drawCount;
+}
+
+void Renderer::Submit(const VertexArray& va, const IndexBuffer& ib, const Shader& shader, unsigned int material, float depth)
+{
+    m_Queue.Submit(va, ib, shader, material, depth);
+}
+
+void Renderer::SubmitInstanced(const VertexArray& va, const IndexBuffer& ib, const Shader& shader, unsigned int instanceCount, unsigned int material, float depth)
+{
+    m_Queue.SubmitInstanced(va, ib, shader, instanceCount, material, depth);
+}
+
+void Renderer::SubmitRange(const VertexArray& va, const IndexBuffer& ib, const Shader& shader, const IndexRange& range, unsigned int material, float depth)
+{
+    m_Queue.SubmitRange(va, ib, shader, range, material, depth);
+}
+
+void Renderer::Flush()
+{
+    size_t total = m_Queue.Size();
+    for (const CommandBuffer& queue : m_WorkerQueues)
+        total += queue.Size();
+    if (total == 0)
+        return;
+
+    m_SortEntries.clear();
+    m_SortEntries.reserve(total);
+    for (const RenderCommand& command : m_Queue.GetCommands())
+        m_SortEntries.push_back({ command.key, &command });
+    for (const CommandBuffer& queue : m_WorkerQueues)
+    {
+        for (const RenderCommand& command : queue.GetCommands())
+            m_SortEntries.push_back({ command.key, &command });
+    }
+    RadixSort(m_SortEntries, m_SortScratch);
+
+    const bool multiDraw = SupportsMultiDrawIndirect();
+    if (multiDraw)
+    {
+        // all indirect commands of this flush go up in one upload
+        m_IndirectCommands.clear();
+        m_IndirectCommands.reserve(total);
+        for (const SortEntry& entry : m_SortEntries)
+        {
+            const RenderCommand& command = *entry.command;
+            m_IndirectCommands.push_back({ command.count, command.instanceCount, command.ib->GetFirstIndex() + command.firstIndex, command.baseVertex, 0 });
+        }
+        if (!m_IndirectBuffer)
+            m_IndirectBuffer = std::make_unique<IndirectBuffer>();
+        m_IndirectBuffer->SetCommands(m_IndirectCommands.data(), (unsigned int)m_IndirectCommands.size());
+    }
+
+    const Shader* shader = nullptr;
+    const VertexArray* va = nullptr;
+    for (size_t i = 0; i < total;)
+    {
+        const RenderCommand& command = *m_SortEntries[i].command;
+        if (command.shader != shader)
+        {
+            BindShader(*command.shader);
+            shader = command.shader;
+        }
+        if (command.va != va)
+        {
+            command.va->Bind();
+            va = command.va;
+        }
+        command.ib->Bind();
+
+        // run of commands that only differ in their draw parameters
+        size_t end = i + 1;
+        while (end < total)
+        {
+            const RenderCommand& next = *m_SortEntries[end].command;
+            // arena views of the same block count as the same index buffer, as long as the index type matches
+            if (next.shader != command.shader || next.va != command.va ||
+                next.ib->GetRendererID() != command.ib->GetRendererID() || next.ib->GetType() != command.ib->GetType())
+                break;
+            end++;
+        }
+
+        if (multiDraw && end - i > 1)
+        {
+            DrawIndirect(*command.va, *command.ib, *command.shader, *m_IndirectBuffer, (unsigned int)(end - i), (unsigned int)i);
+        }
+        else
+        {
+            for (size_t j = i; j < end; j++)
+            {
+                const RenderCommand& run = *m_SortEntries[j].command;
+                DrawElements(*run.ib, run.count, run.ib->GetFirstIndex() + run.firstIndex, run.baseVertex, run.instanceCount);
+                RenderState::GetStats().DrawCalls++;
+            }
+        }
+        i = end;
+    }
+
+    m_Queue.Clear();
+    for (CommandBuffer& queue : m_WorkerQueues)
+        queue.Clear();
+}
+
+void Renderer::SetWorkerCount(unsigned int count)
+{
+    m_WorkerQueues.resize(count);
+}
+
+void Renderer::EndFrame()
+{
+    Flush();
+    ShaderHotReload::Update();
+    DeletionQueue::EndFrame();
+    GLCheckFrame();
+
+    m_FrameStats = RenderState::GetStats();
+    RenderState::GetStats() = RenderStats();
 }
@@ -5,19 +5,188 @@
 #include "VertexArray.h"
 #include "IndexBuffer.h"
 #include "Shader.h"
+#include "CommandBuffer.h"
+#include "IndirectBuffer.h"
+
+#include <memory>
 
 // erroe handling
-#define ASSERT(x) if (!(x)) __debugbreak();
+#if defined(_MSC_VER)
+#define DEBUG_BREAK() __debugbreak()
+#else
+#include <csignal>
+#define DEBUG_BREAK() raise(SIGTRAP)
+#endif
+
+#define ASSERT(x) if (!(x)) DEBUG_BREAK();
+
+// GL error checking level, pick at build time with -DKLGL_GL_CHECK=...
+//   KLGL_GL_CHECK_NONE  - GLCall(x) is just x (default in release)
+//   KLGL_GL_CHECK_FRAME - GLCall only records its call site, errors are drained once per frame by GLCheckFrame
+//   KLGL_GL_CHECK_CALL  - glGetError before and after every call (default in debug),
+//                         can be lowered at runtime with GLSetErrorPolicy
+#define KLGL_GL_CHECK_NONE  0
+#define KLGL_GL_CHECK_FRAME 1
+#define KLGL_GL_CHECK_CALL  2
+
+#ifndef KLGL_GL_CHECK
+#ifdef NDEBUG
+#define KLGL_GL_CHECK KLGL_GL_CHECK_NONE
+#else
+#define KLGL_GL_CHECK KLGL_GL_CHECK_CALL
+#endif
+#endif
+
+enum class GLErrorPolicy
+{
+	None, PerFrame, PerCall
+};
+
+struct GLCallSite
+{
+	const char* function;
+	const char* file;
+	int line;
+};
+
+// last GLCall seen, used to point at the culprit when errors are only checked per frame
+class GLCallTracker
+{
+private:
+	inline static GLCallSite s_LastCall = { nullptr, nullptr, 0 };
+public:
+	inline static void Record(const char* function, const char* file, int line) { s_LastCall = { function, file, line }; }
+	inline static const GLCallSite& GetLastCall() { return s_LastCall; }
+};
+
+inline void GLRecordCall(const char* function, const char* file, int line)
+{
+	GLCallTracker::Record(function, file, line);
+}
+
+#if KLGL_GL_CHECK == KLGL_GL_CHECK_CALL
 #define GLCall(x) GLClearError();\
     x;\
 	ASSERT(GLLogCall(#x, __FILE__, __LINE__))
+#elif KLGL_GL_CHECK == KLGL_GL_CHECK_FRAME
+#define GLCall(x) x;\
+	GLRecordCall(#x, __FILE__, __LINE__)
+#else
+#define GLCall(x) x
+#endif
 
 void GLClearError();
 
 bool GLLogCall(const char* function, const char* file, int line);
 
+// drain all pending GL errors, reporting them against the last recorded call site
+bool GLCheckFrame();
+
+// runtime policy, only has an effect in KLGL_GL_CHECK_CALL builds
+void GLSetErrorPolicy(GLErrorPolicy policy);
+GLErrorPolicy GLGetErrorPolicy();
+
+struct RenderStats
+{
+	// GL draw calls issued, a multi-draw counts once
+	unsigned int DrawCalls = 0;
+	// draws executed through multi-draw indirect
+	unsigned int IndirectDraws = 0;
+	// binds that reached the driver
+	unsigned int ProgramBinds = 0;
+	unsigned int VertexArrayBinds = 0;
+	unsigned int BufferBinds = 0;
+	// binds skipped because the object was already bound
+	unsigned int SkippedBinds = 0;
+};
+
+// Tracks what is bound on the (single) GL context so that Bind() on an object
+// that is already bound never reaches the driver. Code that binds programs,
+// VAOs or array/element buffers without going through here has to call Invalidate().
+class RenderState
+{
+private:
+	static constexpr unsigned int s_Unknown = 0xFFFFFFFF;
+
+	static unsigned int s_Program;
+	static unsigned int s_VertexArray;
+	static unsigned int s_ArrayBuffer;
+	static unsigned int s_ElementBuffer;
+	static unsigned int s_IndirectBuffer;
+	static RenderStats s_Stats;
+public:
+	static void UseProgram(unsigned int id);
+	static void BindVertexArray(unsigned int id);
+	static void BindBuffer(unsigned int target, unsigned int id);
+
+	// keep the cache valid when names are deleted (and possibly reused)
+	static void OnDeleteProgram(unsigned int id);
+	static void OnDeleteVertexArray(unsigned int id);
+	static void OnDeleteBuffer(unsigned int id);
+
+	static void Invalidate();
+
+	static inline RenderStats& GetStats() { return s_Stats; }
+};
+
 class Renderer
 {
+private:
+	RenderStats m_FrameStats;
+	CommandBuffer m_Queue;
+	std::vector<CommandBuffer> m_WorkerQueues;
+	std::vector<SortEntry> m_SortEntries;
+	std::vector<SortEntry> m_SortScratch;
+	// indirect commands built by Flush, uploaded once per flush
+	std::vector<DrawElementsIndirectCommand> m_IndirectCommands;
+	std::unique_ptr<IndirectBuffer> m_IndirectBuffer;
+	// drawn instead of shaders that are still compiling (or failed), made on first use
+	mutable std::unique_ptr<Shader> m_FallbackShader;
+
+	void BindShader(const Shader& shader) const;
 public:
+	// immediate mode. A shader that isn't ready yet (Shader::SetAsyncCompilation) is replaced by a
+	// flat magenta placeholder that only reads the position at location 0, nothing waits for the driver.
 	void Draw(const VertexArray& va, const IndexBuffer& ib, const Shader& shader) const;
+	// one call for instanceCount copies, per-instance data comes from VertexBufferLayout::PushInstanced streams
+	void DrawInstanced(const VertexArray& va, const IndexBuffer& ib, const Shader& shader, unsigned int instanceCount) const;
+	// sub-range of a shared index buffer (see MeshPacker)
+	void DrawRange(const VertexArray& va, const IndexBuffer& ib, const Shader& shader, const IndexRange& range, unsigned int instanceCount = 1) const;
+	// drawCount commands from commands, starting at firstCommand, in one glMultiDrawElementsIndirect
+	// (emulated with a loop of draws when the extension is missing). The commands' firstIndex
+	// is relative to the GL buffer, so add ib.GetFirstIndex() for arena views.
+	void DrawIndirect(const VertexArray& va, const IndexBuffer& ib, const Shader& shader, const IndirectBuffer& commands, unsigned int drawCount, unsigned int firstCommand = 0) const;
+
+	// GL 4.3 or ARB_multi_draw_indirect
+	static bool SupportsMultiDrawIndirect();
+	// GL 4.5 or ARB_direct_state_access (+ vertex_attrib_binding). When true, resources are created
+	// with glCreate* and edited by name, without touching the bindings RenderState caches.
+	static bool UseDirectStateAccess();
+	// force the bind-to-edit path (driver bugs, comparisons). Call before creating resources,
+	// objects made by one path aren't always valid for the other.
+	static void SetDirectStateAccessEnabled(bool enabled);
+
+	// deferred mode: record now, Flush sorts by SortKey and issues with minimal state changes.
+	// va/ib/shader have to stay alive until the flush.
+	void Submit(const VertexArray& va, const IndexBuffer& ib, const Shader& shader, unsigned int material = 0, float depth = 0.0f);
+	void SubmitInstanced(const VertexArray& va, const IndexBuffer& ib, const Shader& shader, unsigned int instanceCount, unsigned int material = 0, float depth = 0.0f);
+	void SubmitRange(const VertexArray& va, const IndexBuffer& ib, const Shader& shader, const IndexRange& range, unsigned int material = 0, float depth = 0.0f);
+	// consecutive commands sharing shader, vertex array and index buffer are merged
+	// into one multi-draw indirect call when supported
+	void Flush();
+
+	// Per-worker queues for recording on other threads. Worker i only ever touches
+	// GetWorkerQueue(i), so recording needs no locks; Flush (render thread) merges and
+	// sorts all of them with the main queue. The caller makes sure the workers are
+	// done (join/barrier) before Flush and doesn't resize while they are recording.
+	void SetWorkerCount(unsigned int count);
+	inline CommandBuffer& GetWorkerQueue(unsigned int worker) { return m_WorkerQueues[worker]; }
+	inline unsigned int GetWorkerCount() const { return (unsigned int)m_WorkerQueues.size(); }
+
+	// call once per frame before presenting, flushes anything still queued, swaps in
+	// reloaded shaders (ShaderHotReload) and frees resources whose deletion was deferred (DeletionQueue)
+	void EndFrame();
+
+	// counters of the last finished frame
+	inline const RenderStats& GetFrameStats() const { return m_FrameStats; }
 };
\ No newline at end of file
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+// Generational handle into a ResourceRegistry<T>. A destroyed resource's slot gets reused with a
+// new generation, so old handles stop resolving instead of pointing at whatever lives there now.
+template<typename T>
+struct Handle
+{
+	uint32_t index = 0;
+	// 0 = null handle, live slots start at 1
+	uint32_t generation = 0;
+
+	inline bool IsNull() const { return generation == 0; }
+	inline bool operator==(const Handle& other) const { return index == other.index && generation == other.generation; }
+	inline bool operator!=(const Handle& other) const { return !(*this == other); }
+};
+
+// Owns resources (VertexBuffer, Shader, ...) in place in one vector and hands out handles, for
+// resources shared between systems that shouldn't hold raw pointers or own them.
+// Pointers from Get are only valid until the next Create (the vector may grow). Not thread safe.
+template<typename T>
+class ResourceRegistry
+{
+private:
+	struct Slot
+	{
+		std::optional<T> resource;
+		uint32_t generation;
+	};
+
+	std::vector<Slot> m_Slots;
+	std::vector<uint32_t> m_FreeSlots;
+	unsigned int m_Count = 0;
+public:
+	template<typename... Args>
+	Handle<T> Create(Args&&... args)
+	{
+		uint32_t index;
+		if (!m_FreeSlots.empty())
+		{
+			index = m_FreeSlots.back();
+			m_FreeSlots.pop_back();
+		}
+		else
+		{
+			index = (uint32_t)m_Slots.size();
+			m_Slots.push_back({ std::nullopt, 1 });
+		}
+
+		m_Slots[index].resource.emplace(std::forward<Args>(args)...);
+		m_Count++;
+		return { index, m_Slots[index].generation };
+	}
+
+	// takes over an existing resource
+	Handle<T> Add(T&& resource)
+	{
+		return Create(std::move(resource));
+	}
+
+	// deletes the resource, false if the handle was already stale
+	bool Destroy(Handle<T> handle)
+	{
+		if (!IsValid(handle))
+			return false;
+
+		Slot& slot = m_Slots[handle.index];
+		slot.resource.reset();
+		m_Count--;
+		// a slot whose generation would wrap around to 0 is retired for good
+		if (++slot.generation != 0)
+			m_FreeSlots.push_back(handle.index);
+		return true;
+	}
+
+	bool IsValid(Handle<T> handle) const
+	{
+		return !handle.IsNull() && handle.index < m_Slots.size()
+			&& m_Slots[handle.index].generation == handle.generation && m_Slots[handle.index].resource;
+	}
+
+	// nullptr for stale/null handles
+	T* Get(Handle<T> handle)
+	{
+		return IsValid(handle) ? &*m_Slots[handle.index].resource : nullptr;
+	}
+
+	const T* Get(Handle<T> handle) const
+	{
+		return IsValid(handle) ? &*m_Slots[handle.index].resource : nullptr;
+	}
+
+	inline unsigned int GetCount() const { return m_Count; }
+
+	// calls f(handle, resource) for every live resource
+	template<typename F>
+	void ForEach(F&& f)
+	{
+		for (uint32_t i = 0; i < m_Slots.size(); i++)
+		{
+			if (m_Slots[i].resource)
+				f(Handle<T>{ i, m_Slots[i].generation }, *m_Slots[i].resource);
+		}
+	}
+};
@@ -1,36 +1,213 @@
 #include "Shader.h"
 
 #include <iostream>
-#include <fstream>
 #include <string>
-#include <sstream>
+
+#ifdef _WIN32
+#include <malloc.h>
+#else
+#include <alloca.h>
+#endif
 
 #include "Renderer.h"
+#include "DeletionQueue.h"
+#include "ProgramBinaryCache.h"
+#include "ShaderHotReload.h"
+
+bool Shader::s_AsyncCompilation = false;
+
+Shader::Shader(const std::string& filepath, const std::vector<std::string>& defines)
+	: m_FilePath(filepath), m_Defines(defines), m_RendererID(0), m_Status(ShaderStatus::Compiling)
+{
+    ShaderProgramSource source = ShaderPreprocessor::Preprocess(filepath, defines);
+    m_SourceFiles = std::move(source.Files);
+    m_Pending = CreateProgram(source);
+    m_RendererID = m_Pending.program;
+    if (!s_AsyncCompilation)
+        FinishCreateShader();
+    ShaderHotReload::Register(this);
+}
 
-Shader::Shader(const std::string& filepath)
-	: m_FilePath(filepath), m_RendererID(0)
+Shader::Shader(const ShaderProgramSource& source, const std::string& name)
+    : m_FilePath(name), m_RendererID(0), m_Status(ShaderStatus::Compiling)
 {
-    ShaderProgramSource source = ParseShader(filepath);
-    m_RendererID = CreateShader(source.VertexSource, source.FragmentSource);
+    m_Pending = CreateProgram(source);
+    m_RendererID = m_Pending.program;
+    if (!s_AsyncCompilation)
+        FinishCreateShader();
 }
 
 Shader::~Shader()
 {
-    GLCall(glDeleteProgram(m_RendererID));
+    ShaderHotReload::Unregister(this);
+    DeleteShaders(m_Pending);
+    DeleteShaders(m_Reload);
+    DeletionQueue::Enqueue(GLObjectType::Program, m_Reload.program);
+    DeletionQueue::Enqueue(GLObjectType::Program, m_RendererID);
+}
+
+Shader::Shader(Shader&& other) noexcept
+    : m_FilePath(std::move(other.m_FilePath)), m_Defines(std::move(other.m_Defines)),
+      m_SourceFiles(std::move(other.m_SourceFiles)), m_RendererID(other.m_RendererID),
+      m_UniformLocationCache(std::move(other.m_UniformLocationCache)), m_Status(other.m_Status),
+      m_Pending(other.m_Pending), m_PendingUniforms(std::move(other.m_PendingUniforms)), m_Reload(other.m_Reload)
+{
+    other.m_RendererID = 0;
+    other.m_Pending = PendingProgram();
+    other.m_Reload = PendingProgram();
+    ShaderHotReload::OnMoved(&other, this);
+}
+
+Shader& Shader::operator=(Shader&& other) noexcept
+{
+    if (this != &other)
+    {
+        ShaderHotReload::Unregister(this);
+        DeleteShaders(m_Pending);
+        DeleteShaders(m_Reload);
+        DeletionQueue::Enqueue(GLObjectType::Program, m_Reload.program);
+        DeletionQueue::Enqueue(GLObjectType::Program, m_RendererID);
+        m_FilePath = std::move(other.m_FilePath);
+        m_Defines = std::move(other.m_Defines);
+        m_SourceFiles = std::move(other.m_SourceFiles);
+        m_RendererID = other.m_RendererID;
+        m_UniformLocationCache = std::move(other.m_UniformLocationCache);
+        m_Status = other.m_Status;
+        m_Pending = other.m_Pending;
+        m_PendingUniforms = std::move(other.m_PendingUniforms);
+        m_Reload = other.m_Reload;
+        other.m_RendererID = 0;
+        other.m_Pending = PendingProgram();
+        other.m_Reload = PendingProgram();
+        ShaderHotReload::OnMoved(&other, this);
+    }
+    return *this;
+}
+
+bool Shader::SupportsParallelCompilation()
+{
+    return GLEW_KHR_parallel_shader_compile || GLEW_ARB_parallel_shader_compile;
+}
+
+bool Shader::SupportsProgramUniforms()
+{
+    return GLEW_VERSION_4_1 || GLEW_ARB_separate_shader_objects;
+}
+
+void Shader::SetAsyncCompilation(bool enabled)
+{
+    s_AsyncCompilation = enabled;
+    if (!enabled)
+        return;
+
+    // let the driver pick the number of compiler threads
+    if (GLEW_KHR_parallel_shader_compile)
+    {
+        GLCall(glMaxShaderCompilerThreadsKHR(0xFFFFFFFF));
+    }
+    else if (GLEW_ARB_parallel_shader_compile)
+    {
+        GLCall(glMaxShaderCompilerThreadsARB(0xFFFFFFFF));
+    }
+}
+
+bool Shader::IsReady() const
+{
+    if (m_Status == ShaderStatus::Compiling && IsProgramDone(m_Pending))
+        FinishCreateShader();
+    return m_Status == ShaderStatus::Ready;
+}
+
+void Shader::WaitUntilReady() const
+{
+    if (m_Status == ShaderStatus::Compiling)
+        FinishCreateShader();
+}
+
+void Shader::Reload()
+{
+    // a reload still in flight is outdated now
+    DeleteShaders(m_Reload);
+    DeletionQueue::Enqueue(GLObjectType::Program, m_Reload.program);
+
+    // the first compile has to be settled, the swap needs to know what it replaces
+    WaitUntilReady();
+    ShaderProgramSource source = ShaderPreprocessor::Preprocess(m_FilePath, m_Defines);
+    // the file may be gone for a moment mid-save, the next change event retries
+    if (source.Files.empty())
+    {
+        std::cout << "Reloading " << m_FilePath << " failed, keeping the old program" << std::endl;
+        return;
+    }
+    m_Reload = CreateProgram(source);
+
+    // includes may have been added or removed
+    if (source.Files != m_SourceFiles)
+    {
+        m_SourceFiles = std::move(source.Files);
+        ShaderHotReload::Unregister(this);
+        ShaderHotReload::Register(this);
+    }
+}
+
+bool Shader::UpdateReload()
+{
+    if (m_Reload.program == 0 || !IsProgramDone(m_Reload))
+        return false;
+
+    PendingProgram reload = m_Reload;
+    m_Reload = PendingProgram();
+    if (!FinishProgram(reload))
+    {
+        std::cout << "Reloading " << m_FilePath << " failed, keeping the old program" << std::endl;
+        DeletionQueue::Enqueue(GLObjectType::Program, reload.program);
+        return false;
+    }
+
+    // locations can change between versions
+    if (m_Status == ShaderStatus::Ready)
+        CopyUniforms(m_RendererID, reload.program);
+    DeletionQueue::Enqueue(GLObjectType::Program, m_RendererID);
+    m_RendererID = reload.program;
+    m_UniformLocationCache.clear();
+
+    // a fixed shader that failed before gets the uniforms it was given in the meantime
+    if (m_Status != ShaderStatus::Ready)
+    {
+        m_Status = ShaderStatus::Ready;
+        ApplyPendingUniforms();
+    }
+    std::cout << "Reloaded " << m_FilePath << std::endl;
+    return true;
 }
 
 void Shader::Bind() const
 {
-    GLCall(glUseProgram(m_RendererID));
+    WaitUntilReady();
+    RenderState::UseProgram(m_RendererID);
 }
 
 void Shader::Unbind() const
 {
-    GLCall(glUseProgram(0));
+    RenderState::UseProgram(0);
 }
 
 void Shader::SetUniform4f(const std::string& name, float v0, float v1, float v2, float v3)
 {
+    // an unlinked (or failed) program has no uniform locations
+    if (m_Status != ShaderStatus::Ready)
+    {
+        m_PendingUniforms[name] = { v0, v1, v2, v3 };
+        return;
+    }
+
+    // with glProgramUniform the program doesn't have to be bound
+    if (SupportsProgramUniforms())
+    {
+        GLCall(glProgramUniform4f(m_RendererID, GetUniformLocation(name), v0, v1, v2, v3));
+        return;
+    }
+    RenderState::UseProgram(m_RendererID);
     GLCall(glUniform4f(GetUniformLocation(name), v0, v1, v2, v3));
 }
 
@@ -47,76 +224,300 @@ unsigned int Shader::GetUniformLocation(const std::string& name)
     return location;
 }
 
-ShaderProgramSource Shader::ParseShader(const std::string& filepath)
+static unsigned int GetGLStage(ShaderStage stage)
 {
-    std::ifstream stream(filepath);
+    switch (stage)
+    {
+    case ShaderStage::Vertex:           return GL_VERTEX_SHADER;
+    case ShaderStage::Fragment:         return GL_FRAGMENT_SHADER;
+    case ShaderStage::Geometry:         return GL_GEOMETRY_SHADER;
+    case ShaderStage::TessControl:      return GL_TESS_CONTROL_SHADER;
+    case ShaderStage::TessEvaluation:   return GL_TESS_EVALUATION_SHADER;
+    default:                            return GL_COMPUTE_SHADER;
+    }
+}
 
-    enum class ShaderType
+// Compile Shader, the result is checked in FinishProgram
+unsigned int Shader::CompileShader(unsigned int type, const std::string& source)
+{
+    unsigned int id = glCreateShader(type); // Create shader
+    const char* src = source.c_str(); // Get source
+    glShaderSource(id, 1, &src, nullptr); // Set source
+    glCompileShader(id); // Compile shader
+    return id;
+}
+
+Shader::PendingProgram Shader::CreateProgram(const ShaderProgramSource& source)
+{
+    PendingProgram pending;
+
+    // a cached binary skips compiling and linking completely
+    pending.cacheKey = ProgramBinaryCache::MakeKey({ source.VertexSource, source.FragmentSource, source.GeometrySource,
+        source.TessControlSource, source.TessEvaluationSource, source.ComputeSource });
+    pending.program = ProgramBinaryCache::Load(pending.cacheKey);
+    if (pending.program != 0)
+    {
+        pending.cached = true;
+        return pending;
+    }
+
+    unsigned int program = glCreateProgram();
+    for (int stage = 0; stage < (int)ShaderStage::Count; stage++)
     {
-        NONE = -1, VERTEX = 0, FRAGMENT = 1
-    };
+        const std::string& stageSource = source.Get((ShaderStage)stage);
+        if (stageSource.empty())
+            continue;
+        pending.shaders[stage] = CompileShader(GetGLStage((ShaderStage)stage), stageSource);
+        glAttachShader(program, pending.shaders[stage]);
+    }
+    ProgramBinaryCache::PrepareForStore(program);
+    // no status queries here, any of them would wait for the compile
+    glLinkProgram(program);
+
+    pending.program = program;
+    return pending;
+}
 
-    std::string line;
-    std::stringstream ss[2];
-    ShaderType type = ShaderType::NONE;
-    while (getline(stream, line))
+bool Shader::IsProgramDone(const PendingProgram& pending)
+{
+    // without the extension the link status query in FinishProgram just waits
+    if (pending.cached || !SupportsParallelCompilation())
+        return true;
+
+    int done = GL_FALSE;
+    GLCall(glGetProgramiv(pending.program, GL_COMPLETION_STATUS_KHR, &done));
+    return done != GL_FALSE;
+}
+
+bool Shader::FinishProgram(PendingProgram& pending) const
+{
+    int linked;
+    glGetProgramiv(pending.program, GL_LINK_STATUS, &linked);
+    if (linked == GL_FALSE)
+    {
+        // Error handling, a failed compile shows up as a failed link
+        bool compileFailed = false;
+        for (int stage = 0; stage < (int)ShaderStage::Count; stage++)
+        {
+            unsigned int id = pending.shaders[stage];
+            if (id == 0)
+                continue;
+            int result;
+            glGetShaderiv(id, GL_COMPILE_STATUS, &result);
+            if (result == GL_FALSE)
+            {
+                int length;
+                glGetShaderiv(id, GL_INFO_LOG_LENGTH, &length);
+                char* message = (char*)alloca(length * sizeof(char)); // allocate on stack
+                glGetShaderInfoLog(id, length, &length, message);
+                std::cout << "Failed to compile " << ShaderPreprocessor::GetStageName((ShaderStage)stage) << " (" << m_FilePath << ")" << std::endl;
+                std::cout << message << std::endl;
+                compileFailed = true;
+            }
+        }
+        if (!compileFailed)
+        {
+            int length;
+            glGetProgramiv(pending.program, GL_INFO_LOG_LENGTH, &length);
+            char* message = (char*)alloca((length + 1) * sizeof(char));
+            message[0] = 0;
+            glGetProgramInfoLog(pending.program, length + 1, &length, message);
+            std::cout << "Failed to link " << m_FilePath << std::endl;
+            std::cout << message << std::endl;
+        }
+    }
+
+    DeleteShaders(pending);
+    if (linked != GL_FALSE && !pending.cached)
+        ProgramBinaryCache::Store(pending.cacheKey, pending.program);
+    return linked != GL_FALSE;
+}
+
+void Shader::DeleteShaders(PendingProgram& pending)
+{
+    // queued like the programs, a Shader may be destroyed on any thread
+    for (unsigned int& id : pending.shaders)
+    {
+        DeletionQueue::Enqueue(GLObjectType::Shader, id);
+        id = 0;
+    }
+}
+
+void Shader::FinishCreateShader() const
+{
+    if (!FinishProgram(m_Pending))
+    {
+        m_Status = ShaderStatus::Failed;
+        return;
+    }
+
+    m_Status = ShaderStatus::Ready;
+    ApplyPendingUniforms();
+}
+
+void Shader::ApplyPendingUniforms() const
+{
+    for (const auto& [name, value] : m_PendingUniforms)
     {
-        if (line.find("#shader") != std::string::npos)
+        int location = glGetUniformLocation(m_RendererID, name.c_str());
+        if (location == -1)
+            std::cout << "Warning: uniform '" << name << "' doesn't exist!" << std::endl;
+        if (SupportsProgramUniforms())
         {
-            if (line.find("vertex") != std::string::npos)
-                type = ShaderType::VERTEX;
-            else if (line.find("fragment") != std::string::npos)
-                type = ShaderType::FRAGMENT;
+            GLCall(glProgramUniform4f(m_RendererID, location, value[0], value[1], value[2], value[3]));
         }
         else
         {
-            ss[(int)type] << line << '\n';
+            RenderState::UseProgram(m_RendererID);
+            GLCall(glUniform4f(location, value[0], value[1], value[2], value[3]));
         }
     }
+    m_PendingUniforms.clear();
+}
 
-    return { ss[0].str(), ss[1].str() };
+// components of the uniform types CopyUniforms carries over, 0 for everything else
+static int UniformComponents(unsigned int type, bool& isFloat)
+{
+    isFloat = true;
+    switch (type)
+    {
+    case GL_FLOAT:          return 1;
+    case GL_FLOAT_VEC2:     return 2;
+    case GL_FLOAT_VEC3:     return 3;
+    case GL_FLOAT_VEC4:     return 4;
+    case GL_FLOAT_MAT4:     return 16;
+    }
 
+    // samplers are texture units, plain ints
+    isFloat = false;
+    switch (type)
+    {
+    case GL_INT:
+    case GL_BOOL:
+    case GL_SAMPLER_2D:
+    case GL_SAMPLER_3D:
+    case GL_SAMPLER_CUBE:
+    case GL_SAMPLER_2D_ARRAY:
+    case GL_SAMPLER_2D_SHADOW:
+                            return 1;
+    case GL_INT_VEC2:       return 2;
+    case GL_INT_VEC3:       return 3;
+    case GL_INT_VEC4:       return 4;
+    }
+    return 0;
 }
 
-// Compile Shader
-unsigned int Shader::CompileShader(unsigned int type, const std::string& source)
+// glProgramUniform* for CopyUniforms, see SupportsProgramUniforms
+static void SetProgramUniform(unsigned int program, int location, int components, const float* value)
 {
-    unsigned int id = glCreateShader(type); // Create shader
-    const char* src = source.c_str(); // Get source
-    glShaderSource(id, 1, &src, nullptr); // Set source
-    glCompileShader(id); // Compile shader
+    switch (components)
+    {
+    case 1:  GLCall(glProgramUniform1fv(program, location, 1, value)); break;
+    case 2:  GLCall(glProgramUniform2fv(program, location, 1, value)); break;
+    case 3:  GLCall(glProgramUniform3fv(program, location, 1, value)); break;
+    case 4:  GLCall(glProgramUniform4fv(program, location, 1, value)); break;
+    case 16: GLCall(glProgramUniformMatrix4fv(program, location, 1, GL_FALSE, value)); break;
+    }
+}
 
-    // Error handling
-    int result;
-    glGetShaderiv(id, GL_COMPILE_STATUS, &result);
-    if (result == GL_FALSE)
+static void SetProgramUniform(unsigned int program, int location, int components, const int* value)
+{
+    switch (components)
     {
-        int length;
-        glGetShaderiv(id, GL_INFO_LOG_LENGTH, &length);
-        char* message = (char*)alloca(length * sizeof(char)); // allocate on stack
-        glGetShaderInfoLog(id, length, &length, message);
-        std::cout << "Failed to compile " << (type == GL_VERTEX_SHADER ? "vertex" : "fragment") << std::endl;
-        std::cout << message << std::endl;
-        glDeleteShader(id); // delete shader
-        return 0;
+    case 1: GLCall(glProgramUniform1iv(program, location, 1, value)); break;
+    case 2: GLCall(glProgramUniform2iv(program, location, 1, value)); break;
+    case 3: GLCall(glProgramUniform3iv(program, location, 1, value)); break;
+    case 4: GLCall(glProgramUniform4iv(program, location, 1, value)); break;
     }
+}
 
-    return id;
+// same on the bound program, for 3.3 contexts
+static void SetBoundUniform(int location, int components, const float* value)
+{
+    switch (components)
+    {
+    case 1:  GLCall(glUniform1fv(location, 1, value)); break;
+    case 2:  GLCall(glUniform2fv(location, 1, value)); break;
+    case 3:  GLCall(glUniform3fv(location, 1, value)); break;
+    case 4:  GLCall(glUniform4fv(location, 1, value)); break;
+    case 16: GLCall(glUniformMatrix4fv(location, 1, GL_FALSE, value)); break;
+    }
 }
 
-unsigned int Shader::CreateShader(const std::string& vertexShader, const std::string& fragmentShader)
+static void SetBoundUniform(int location, int components, const int* value)
 {
-    unsigned int program = glCreateProgram();
-    unsigned int vs = CompileShader(GL_VERTEX_SHADER, vertexShader);
-    unsigned int fs = CompileShader(GL_FRAGMENT_SHADER, fragmentShader);
+    switch (components)
+    {
+    case 1: GLCall(glUniform1iv(location, 1, value)); break;
+    case 2: GLCall(glUniform2iv(location, 1, value)); break;
+    case 3: GLCall(glUniform3iv(location, 1, value)); break;
+    case 4: GLCall(glUniform4iv(location, 1, value)); break;
+    }
+}
 
-    glAttachShader(program, vs);
-    glAttachShader(program, fs);
-    glLinkProgram(program);
-    glValidateProgram(program);
+void Shader::CopyUniforms(unsigned int from, unsigned int to)
+{
+    // matched by name and type, new or retyped uniforms keep their defaults.
+    // without glProgramUniform* the new program gets bound, it replaces the old one anyway
+    const bool separate = SupportsProgramUniforms();
+    if (!separate)
+        RenderState::UseProgram(to);
 
-    glDeleteShader(vs);
-    glDeleteShader(fs);
+    int count = 0;
+    GLCall(glGetProgramiv(from, GL_ACTIVE_UNIFORMS, &count));
+    for (int i = 0; i < count; i++)
+    {
+        char name[256];
+        int size;
+        unsigned int type;
+        GLCall(glGetActiveUniform(from, i, sizeof(name), nullptr, &size, &type, name));
+
+        bool isFloat;
+        const int components = UniformComponents(type, isFloat);
+        if (components == 0)
+            continue;
+
+        const char* activeName = name;
+        unsigned int index = GL_INVALID_INDEX;
+        GLCall(glGetUniformIndices(to, 1, &activeName, &index));
+        if (index == GL_INVALID_INDEX)
+            continue;
+        int newType = 0;
+        GLCall(glGetActiveUniformsiv(to, 1, &index, GL_UNIFORM_TYPE, &newType));
+        if ((unsigned int)newType != type)
+            continue;
+
+        // arrays show up once as "name[0]"
+        std::string base = name;
+        if (size > 1 && base.size() > 3 && base.compare(base.size() - 3, 3, "[0]") == 0)
+            base.resize(base.size() - 3);
+        for (int element = 0; element < size; element++)
+        {
+            const std::string elementName = size > 1 ? base + "[" + std::to_string(element) + "]" : base;
+            // -1 for uniform block members, they live in buffers
+            int oldLocation = glGetUniformLocation(from, elementName.c_str());
+            int newLocation = glGetUniformLocation(to, elementName.c_str());
+            if (oldLocation == -1 || newLocation == -1)
+                continue;
 
-    return program;
-}
\ No newline at end of file
+            if (isFloat)
+            {
+                float value[16];
+                GLCall(glGetUniformfv(from, oldLocation, value));
+                if (separate)
+                    SetProgramUniform(to, newLocation, components, value);
+                else
+                    SetBoundUniform(newLocation, components, value);
+            }
+            else
+            {
+                int value[4];
+                GLCall(glGetUniformiv(from, oldLocation, value));
+                if (separate)
+                    SetProgramUniform(to, newLocation, components, value);
+                else
+                    SetBoundUniform(newLocation, components, value);
+            }
+        }
+    }
+}
@@ -1,35 +1,116 @@
 #pragma once
 
+#include <array>
+#include <cstdint>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
-// struct to store shader files
-struct ShaderProgramSource
+#include "ShaderPreprocessor.h"
+
+enum class ShaderStatus
 {
-	std::string VertexSource;
-	std::string FragmentSource;
+	// submitted, the driver may still be compiling/linking (async compilation)
+	Compiling,
+	Ready,
+	// compile or link error, already printed
+	Failed
 };
 
 class Shader
 {
 private:
+	// a program that is submitted, but whose compile/link result hasn't been looked at yet
+	struct PendingProgram
+	{
+		unsigned int program = 0;
+		// per ShaderStage, 0 for stages the program doesn't have. Kept until the link result is
+		// known, for their info logs
+		unsigned int shaders[(int)ShaderStage::Count] = {};
+		uint64_t cacheKey = 0;
+		// loaded from the ProgramBinaryCache, already linked
+		bool cached = false;
+	};
+
+	static bool s_AsyncCompilation;
+
 	std::string m_FilePath;
+	// injected after #version, kept for Reload
+	std::vector<std::string> m_Defines;
+	// the file and its includes, see ShaderHotReload
+	std::vector<std::string> m_SourceFiles;
 	unsigned int m_RendererID;
 	std::unordered_map<std::string, int> m_UniformLocationCache;
+	// The result of an async compile is only looked at once the driver says it's done, which can
+	// happen in const calls (IsReady from the Renderer), hence mutable.
+	mutable ShaderStatus m_Status;
+	// the first compile, its program is m_RendererID
+	mutable PendingProgram m_Pending;
+	// uniforms set before the program was usable, applied when it is
+	mutable std::unordered_map<std::string, std::array<float, 4>> m_PendingUniforms;
+	// new program from Reload, m_RendererID stays in use until it links
+	PendingProgram m_Reload;
 public:
-	Shader(const std::string& filepath);
+	// .shader file with any number of #shader stages and #includes (ShaderPreprocessor), defines
+	// are "NAME" or "NAME VALUE". Files are watched for changes while ShaderHotReload is enabled.
+	Shader(const std::string& filepath, const std::vector<std::string>& defines = {});
+	// program from memory, name is only used in messages
+	Shader(const ShaderProgramSource& source, const std::string& name);
 	~Shader();
 
+	// move-only, see VertexBuffer
+	Shader(const Shader&) = delete;
+	Shader& operator=(const Shader&) = delete;
+	Shader(Shader&& other) noexcept;
+	Shader& operator=(Shader&& other) noexcept;
+
+	// KHR_parallel_shader_compile or ARB_parallel_shader_compile
+	static bool SupportsParallelCompilation();
+	// glProgramUniform* (GL 4.1 or ARB_separate_shader_objects, not part of ARB_direct_state_access),
+	// without it uniforms are set by binding the program
+	static bool SupportsProgramUniforms();
+	// Shaders created from now on are compiled and linked without waiting for the result, so creating
+	// several of them overlaps their compiles on the driver's threads. Poll IsReady, the Renderer
+	// draws with a placeholder until then. Call after the context exists.
+	static void SetAsyncCompilation(bool enabled);
+
+	// Linked and usable. Never blocks with parallel compile support (GL_COMPLETION_STATUS_KHR),
+	// without it the first call waits for the driver. Stays false if the program failed.
+	bool IsReady() const;
+	// blocks until the driver is done, check IsReady/GetStatus for the result
+	void WaitUntilReady() const;
+	inline ShaderStatus GetStatus() const { return m_Status; }
+
+	// Recompiles the file in the background (always async), the current program stays in use.
+	// UpdateReload swaps the new one in if it links, with the uniform values carried over; if it
+	// doesn't, the errors are printed and the old program is kept. ShaderHotReload drives this.
+	void Reload();
+	// true when the reloaded program was swapped in just now
+	bool UpdateReload();
+	inline bool IsReloading() const { return m_Reload.program != 0; }
+
+	// waits for the program if it's still compiling
 	void Bind() const;
 	void Unbind() const;
 
-	// Set uniforms
+	inline unsigned int GetRendererID() const { return m_RendererID; }
+	inline const std::string& GetFilePath() const { return m_FilePath; }
+	inline const std::vector<std::string>& GetSourceFiles() const { return m_SourceFiles; }
+
+	// Set uniforms, deferred until the program is ready
 	void SetUniform4f(const std::string& name, float v0, float v1, float v2, float v3);
 private:
-	ShaderProgramSource ParseShader(const std::string& filepath);
 	unsigned int CompileShader(unsigned int type, const std::string& source);
-	unsigned int CreateShader(const std::string& vertexShader, const std::string& fragmentShader);
+	// compiles and links without checking anything (or loads a cached binary), see FinishProgram
+	PendingProgram CreateProgram(const ShaderProgramSource& source);
+	static bool IsProgramDone(const PendingProgram& pending);
+	// prints the logs if it failed and deletes the shaders, true if it linked
+	bool FinishProgram(PendingProgram& pending) const;
+	static void DeleteShaders(PendingProgram& pending);
+	void FinishCreateShader() const;
+	void ApplyPendingUniforms() const;
+	static void CopyUniforms(unsigned int from, unsigned int to);
 	
 	unsigned int GetUniformLocation(const std::string& name);
 
-};
\ No newline at end of file
+};
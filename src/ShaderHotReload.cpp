@@ -0,0 +1,197 @@
+#include "ShaderHotReload.h"
+
+#include <algorithm>
+#include <iostream>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include "Shader.h"
+
+std::recursive_mutex ShaderHotReload::s_Mutex;
+bool ShaderHotReload::s_Enabled = false;
+std::vector<ShaderHotReload::Entry> ShaderHotReload::s_Entries;
+int ShaderHotReload::s_Inotify = -1;
+std::vector<std::pair<int, std::string>> ShaderHotReload::s_Watches;
+std::chrono::steady_clock::time_point ShaderHotReload::s_LastPoll;
+const std::chrono::milliseconds ShaderHotReload::s_PollInterval(250);
+
+static std::filesystem::file_time_type GetLastWrite(const std::string& path)
+{
+    std::error_code error;
+    std::filesystem::file_time_type time = std::filesystem::last_write_time(path, error);
+    return error ? std::filesystem::file_time_type() : time;
+}
+
+void ShaderHotReload::Enable()
+{
+    std::lock_guard<std::recursive_mutex> lock(s_Mutex);
+    if (s_Enabled)
+        return;
+    s_Enabled = true;
+
+#ifdef __linux__
+    s_Inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (s_Inotify < 0)
+        std::cout << "Shader hot reload: no inotify, polling instead" << std::endl;
+#endif
+
+    s_LastPoll = std::chrono::steady_clock::now();
+    for (Entry& entry : s_Entries)
+    {
+        WatchDirectory(entry.directory);
+        entry.lastWrite = GetLastWrite(entry.path);
+    }
+}
+
+void ShaderHotReload::Disable()
+{
+    std::lock_guard<std::recursive_mutex> lock(s_Mutex);
+#ifdef __linux__
+    // closing the instance drops its watches too
+    if (s_Inotify >= 0)
+        close(s_Inotify);
+#endif
+    s_Inotify = -1;
+    s_Watches.clear();
+    s_Enabled = false;
+}
+
+void ShaderHotReload::WatchDirectory(const std::string& directory)
+{
+#ifdef __linux__
+    if (s_Inotify < 0)
+        return;
+
+    for (const auto& watch : s_Watches)
+    {
+        if (watch.second == directory)
+            return;
+    }
+
+    // only finished writes: IN_MODIFY would fire halfway through a save
+    int watch = inotify_add_watch(s_Inotify, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+    if (watch < 0)
+    {
+        std::cout << "Shader hot reload: can't watch " << directory << std::endl;
+        return;
+    }
+    s_Watches.push_back({ watch, directory });
+#else
+    (void)directory;
+#endif
+}
+
+void ShaderHotReload::CollectChanges(std::vector<std::string>& changed)
+{
+#ifdef __linux__
+    if (s_Inotify >= 0)
+    {
+        alignas(inotify_event) char buffer[4096];
+        ssize_t length;
+        while ((length = read(s_Inotify, buffer, sizeof(buffer))) > 0)
+        {
+            for (ssize_t offset = 0; offset < length;)
+            {
+                const inotify_event* event = (const inotify_event*)(buffer + offset);
+                offset += sizeof(inotify_event) + event->len;
+                if (event->len == 0)
+                    continue;
+
+                for (const auto& watch : s_Watches)
+                {
+                    if (watch.first == event->wd)
+                    {
+                        changed.push_back((std::filesystem::path(watch.second) / event->name).lexically_normal().string());
+                        break;
+                    }
+                }
+            }
+        }
+        return;
+    }
+#endif
+
+    // stat every file, but not every frame
+    auto now = std::chrono::steady_clock::now();
+    if (now - s_LastPoll < s_PollInterval)
+        return;
+    s_LastPoll = now;
+
+    for (Entry& entry : s_Entries)
+    {
+        std::filesystem::file_time_type lastWrite = GetLastWrite(entry.path);
+        if (lastWrite != entry.lastWrite)
+        {
+            entry.lastWrite = lastWrite;
+            changed.push_back(entry.path);
+        }
+    }
+}
+
+void ShaderHotReload::Update()
+{
+    std::lock_guard<std::recursive_mutex> lock(s_Mutex);
+    if (!s_Enabled)
+        return;
+
+    // an editor save can show up as several events
+    std::vector<std::string> changed;
+    CollectChanges(changed);
+    std::sort(changed.begin(), changed.end());
+    changed.erase(std::unique(changed.begin(), changed.end()), changed.end());
+
+    // Reload re-registers shaders whose includes changed, so not while walking s_Entries
+    std::vector<Shader*> reload;
+    for (const Entry& entry : s_Entries)
+    {
+        if (std::binary_search(changed.begin(), changed.end(), entry.path)
+            && std::find(reload.begin(), reload.end(), entry.shader) == reload.end())
+            reload.push_back(entry.shader);
+    }
+    for (Shader* shader : reload)
+        shader->Reload();
+
+    for (const Entry& entry : s_Entries)
+        entry.shader->UpdateReload();
+}
+
+void ShaderHotReload::Register(Shader* shader)
+{
+    std::lock_guard<std::recursive_mutex> lock(s_Mutex);
+    // one entry per file, the .shader and its includes
+    for (const std::string& file : shader->GetSourceFiles())
+    {
+        std::filesystem::path path = std::filesystem::path(file).lexically_normal();
+        Entry entry;
+        entry.shader = shader;
+        entry.directory = path.has_parent_path() ? path.parent_path().string() : ".";
+        entry.fileName = path.filename().string();
+        entry.path = (std::filesystem::path(entry.directory) / entry.fileName).lexically_normal().string();
+        if (s_Enabled)
+        {
+            WatchDirectory(entry.directory);
+            entry.lastWrite = GetLastWrite(entry.path);
+        }
+        s_Entries.push_back(entry);
+    }
+}
+
+void ShaderHotReload::Unregister(Shader* shader)
+{
+    std::lock_guard<std::recursive_mutex> lock(s_Mutex);
+    s_Entries.erase(std::remove_if(s_Entries.begin(), s_Entries.end(),
+        [shader](const Entry& entry) { return entry.shader == shader; }), s_Entries.end());
+}
+
+void ShaderHotReload::OnMoved(Shader* from, Shader* to)
+{
+    std::lock_guard<std::recursive_mutex> lock(s_Mutex);
+    for (Entry& entry : s_Entries)
+    {
+        if (entry.shader == from)
+            entry.shader = to;
+    }
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <chrono>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class Shader;
+
+// Watches the files of every Shader created from a file (and its #includes) and reloads them when they change (see
+// Shader::Reload): inotify on Linux, polling the modification times every s_PollInterval elsewhere.
+// Directories are watched rather than files, editors like to save by writing a new file and
+// renaming it over the old one. Everything happens on the GL thread in Update, the new program
+// compiles asynchronously and replaces the old one between frames only if it links. Shaders
+// can still be destroyed on any thread, the registration is locked.
+class ShaderHotReload
+{
+private:
+	struct Entry
+	{
+		Shader* shader;
+		// normalized, so inotify's directory + name can be matched against it
+		std::string path;
+		std::string directory;
+		std::string fileName;
+		// polling fallback
+		std::filesystem::file_time_type lastWrite;
+	};
+
+	// held through Update, so a Shader being destroyed elsewhere waits until it's no longer
+	// used; recursive because Shader::Reload re-registers from inside Update
+	static std::recursive_mutex s_Mutex;
+	static bool s_Enabled;
+	static std::vector<Entry> s_Entries;
+	// inotify instance and directory watches, -1 when polling
+	static int s_Inotify;
+	static std::vector<std::pair<int, std::string>> s_Watches;
+	static std::chrono::steady_clock::time_point s_LastPoll;
+	static const std::chrono::milliseconds s_PollInterval;
+
+	static void WatchDirectory(const std::string& directory);
+	static void CollectChanges(std::vector<std::string>& changed);
+public:
+	// shaders that already exist are picked up too
+	static void Enable();
+	static void Disable();
+	inline static bool IsEnabled() { return s_Enabled; }
+
+	// GL thread, once per frame (Renderer::EndFrame): starts reloads of changed files and
+	// swaps in the ones that finished compiling
+	static void Update();
+
+	// called by Shader
+	static void Register(Shader* shader);
+	static void Unregister(Shader* shader);
+	static void OnMoved(Shader* from, Shader* to);
+};
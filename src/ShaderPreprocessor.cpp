@@ -0,0 +1,432 @@
+#include "ShaderPreprocessor.h"
+
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+std::mutex ShaderPreprocessor::s_Mutex;
+std::unordered_map<uint64_t, ShaderPreprocessor::CacheEntry> ShaderPreprocessor::s_Cache;
+unsigned int ShaderPreprocessor::s_Hits = 0;
+unsigned int ShaderPreprocessor::s_Misses = 0;
+
+// read-only view of a whole file
+class MappedFile
+{
+private:
+    const char* m_Data = nullptr;
+    size_t m_Size = 0;
+    bool m_Open = false;
+#ifdef _WIN32
+    HANDLE m_File = INVALID_HANDLE_VALUE;
+    HANDLE m_Mapping = nullptr;
+#endif
+public:
+    MappedFile(const std::string& path)
+    {
+#ifdef _WIN32
+        m_File = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+            nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (m_File == INVALID_HANDLE_VALUE)
+            return;
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(m_File, &size))
+            return;
+        m_Open = true;
+        m_Size = (size_t)size.QuadPart;
+        // empty files can't be mapped
+        if (m_Size == 0)
+            return;
+        m_Mapping = CreateFileMappingA(m_File, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (m_Mapping)
+            m_Data = (const char*)MapViewOfFile(m_Mapping, FILE_MAP_READ, 0, 0, 0);
+        if (!m_Data)
+            m_Open = false;
+#else
+        int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+            return;
+        struct stat info;
+        if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode))
+        {
+            m_Open = true;
+            m_Size = (size_t)info.st_size;
+            // empty files can't be mapped
+            if (m_Size > 0)
+            {
+                void* data = mmap(nullptr, m_Size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (data != MAP_FAILED)
+                    m_Data = (const char*)data;
+                else
+                    m_Open = false;
+            }
+        }
+        // the mapping keeps the file alive
+        close(fd);
+#endif
+    }
+
+    ~MappedFile()
+    {
+#ifdef _WIN32
+        if (m_Data)
+            UnmapViewOfFile(m_Data);
+        if (m_Mapping)
+            CloseHandle(m_Mapping);
+        if (m_File != INVALID_HANDLE_VALUE)
+            CloseHandle(m_File);
+#else
+        if (m_Data)
+            munmap((void*)m_Data, m_Size);
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    inline bool IsOpen() const { return m_Open; }
+    inline std::string_view GetText() const { return std::string_view(m_Data ? m_Data : "", m_Data ? m_Size : 0); }
+};
+
+static uint64_t Fnv1a(uint64_t hash, std::string_view data)
+{
+    for (unsigned char c : data)
+    {
+        hash ^= c;
+        hash *= 0x100000001B3ull;
+    }
+    return hash;
+}
+
+static const uint64_t s_FnvBasis = 0xCBF29CE484222325ull;
+
+static bool IsSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+static std::string_view TrimLeft(std::string_view text)
+{
+    size_t i = 0;
+    while (i < text.size() && IsSpace(text[i]))
+        i++;
+    return text.substr(i);
+}
+
+static bool StartsWithWord(std::string_view text, std::string_view word)
+{
+    return text.size() >= word.size() && text.compare(0, word.size(), word) == 0
+        && (text.size() == word.size() || IsSpace(text[word.size()]) || text[word.size()] == '"' || text[word.size()] == '<');
+}
+
+static bool ParseStage(std::string_view name, ShaderStage& stage)
+{
+    // the word only, comments or whatever follows are ignored
+    size_t end = 0;
+    while (end < name.size() && !IsSpace(name[end]))
+        end++;
+    name = name.substr(0, end);
+
+    if (name == "vertex")
+        stage = ShaderStage::Vertex;
+    else if (name == "fragment" || name == "pixel")
+        stage = ShaderStage::Fragment;
+    else if (name == "geometry")
+        stage = ShaderStage::Geometry;
+    else if (name == "tess_control" || name == "hull")
+        stage = ShaderStage::TessControl;
+    else if (name == "tess_evaluation" || name == "domain")
+        stage = ShaderStage::TessEvaluation;
+    else if (name == "compute")
+        stage = ShaderStage::Compute;
+    else
+        return false;
+    return true;
+}
+
+struct PreprocessContext
+{
+    ShaderProgramSource& source;
+    const std::vector<std::string>& defines;
+    // content hash per entry of source.Files
+    std::vector<uint64_t> hashes;
+    // current stage, -1 before the first #shader
+    int stage = -1;
+    // each stage's #version line, found anywhere (also in an include) and moved to the top
+    std::string versions[(int)ShaderStage::Count];
+    // line of the .shader file the stage starts at, 0 = not seen yet
+    unsigned int firstLines[(int)ShaderStage::Count] = {};
+    // files already pasted into each stage, indices into source.Files
+    std::vector<unsigned int> included[(int)ShaderStage::Count];
+    bool warnedOutsideStage = false;
+};
+
+static void AppendDefines(std::string& out, const std::vector<std::string>& defines)
+{
+    for (const std::string& define : defines)
+    {
+        out += "#define ";
+        out += define;
+        out += '\n';
+    }
+}
+
+static void AppendLine(std::string& out, unsigned int line, unsigned int file)
+{
+    out += "#line ";
+    out += std::to_string(line);
+    out += ' ';
+    out += std::to_string(file);
+    out += '\n';
+}
+
+// depth 0 is the .shader file itself, #shader tags only count there
+static void PreprocessFile(PreprocessContext& context, std::string_view text, unsigned int fileIndex, unsigned int depth)
+{
+    const std::string directory = std::filesystem::path(context.source.Files[fileIndex]).parent_path().string();
+
+    const char* p = text.data();
+    const char* end = p + text.size();
+    unsigned int lineNumber = 0;
+    while (p < end)
+    {
+        const char* lineEnd = (const char*)std::memchr(p, '\n', end - p);
+        if (!lineEnd)
+            lineEnd = end;
+        std::string_view line(p, lineEnd - p);
+        p = lineEnd + 1;
+        lineNumber++;
+
+        std::string_view trimmed = TrimLeft(line);
+        if (!trimmed.empty() && trimmed[0] == '#')
+        {
+            std::string_view directive = TrimLeft(trimmed.substr(1));
+            if (StartsWithWord(directive, "shader"))
+            {
+                ShaderStage stage;
+                if (depth > 0)
+                {
+                    std::cout << "Shader: #shader in included file " << context.source.Files[fileIndex] << " ignored" << std::endl;
+                    if (context.stage >= 0)
+                        context.source.Get((ShaderStage)context.stage) += '\n';
+                }
+                else if (ParseStage(TrimLeft(directive.substr(6)), stage))
+                {
+                    context.stage = (int)stage;
+                    // the #line at the top (see Preprocess) covers the first block, a stage that
+                    // shows up again continues at its new tag
+                    if (context.firstLines[(int)stage] == 0)
+                        context.firstLines[(int)stage] = lineNumber + 1;
+                    else
+                        AppendLine(context.source.Get(stage), lineNumber + 1, 0);
+                }
+                else
+                {
+                    std::cout << "Shader: unknown stage in " << context.source.Files[fileIndex] << ":" << lineNumber << ": " << line << std::endl;
+                    // skip everything up to the next known tag
+                    context.stage = -1;
+                    context.warnedOutsideStage = true;
+                }
+                continue;
+            }
+
+            if (context.stage >= 0 && StartsWithWord(directive, "include"))
+            {
+                // a skipped #include still takes up its line, so the ones after keep their numbers
+                std::string& out = context.source.Get((ShaderStage)context.stage);
+                std::string_view name = TrimLeft(directive.substr(7));
+                const char close = name.empty() ? 0 : (name[0] == '<' ? '>' : '"');
+                size_t nameEnd = name.size() > 1 ? name.find(close, 1) : std::string_view::npos;
+                if (close == 0 || (name[0] != '"' && name[0] != '<') || nameEnd == std::string_view::npos)
+                {
+                    std::cout << "Shader: bad #include in " << context.source.Files[fileIndex] << ":" << lineNumber << std::endl;
+                    out += '\n';
+                    continue;
+                }
+                const std::string path = (std::filesystem::path(directory) / std::string(name.substr(1, nameEnd - 1))).lexically_normal().string();
+
+                unsigned int includeIndex = 0;
+                while (includeIndex < context.source.Files.size() && context.source.Files[includeIndex] != path)
+                    includeIndex++;
+
+                std::vector<unsigned int>& included = context.included[context.stage];
+                bool alreadyIncluded = false;
+                for (unsigned int index : included)
+                    alreadyIncluded |= index == includeIndex;
+                // once per stage, also what stops include cycles. The .shader file itself is never
+                // pasted, it isn't in included
+                if (alreadyIncluded || includeIndex == fileIndex || includeIndex == 0)
+                {
+                    out += '\n';
+                    continue;
+                }
+                if (depth >= 32)
+                {
+                    std::cout << "Shader: #include nesting too deep in " << context.source.Files[fileIndex] << std::endl;
+                    out += '\n';
+                    continue;
+                }
+
+                MappedFile file(path);
+                if (!file.IsOpen())
+                {
+                    std::cout << "Shader: can't open " << path << " (included from " << context.source.Files[fileIndex] << ":" << lineNumber << ")" << std::endl;
+                    out += '\n';
+                    continue;
+                }
+                if (includeIndex == context.source.Files.size())
+                {
+                    context.source.Files.push_back(path);
+                    context.hashes.push_back(Fnv1a(s_FnvBasis, file.GetText()));
+                }
+                included.push_back(includeIndex);
+
+                AppendLine(out, 1, includeIndex);
+                PreprocessFile(context, file.GetText(), includeIndex, depth + 1);
+                // back to where we were, for error line numbers
+                AppendLine(context.source.Get((ShaderStage)context.stage), lineNumber + 1, fileIndex);
+                continue;
+            }
+
+            if (context.stage >= 0 && StartsWithWord(directive, "version") && context.versions[context.stage].empty())
+            {
+                // GLSL wants it first, Preprocess puts it there. An empty line keeps the numbers
+                context.versions[context.stage] = line;
+                context.source.Get((ShaderStage)context.stage) += '\n';
+                continue;
+            }
+        }
+
+        if (context.stage < 0)
+        {
+            // there is no stage to put it in
+            if (!trimmed.empty() && !context.warnedOutsideStage)
+            {
+                std::cout << "Shader: " << context.source.Files[fileIndex] << ":" << lineNumber << " is outside of any #shader block, ignored" << std::endl;
+                context.warnedOutsideStage = true;
+            }
+            continue;
+        }
+
+        std::string& out = context.source.Get((ShaderStage)context.stage);
+        out += line;
+        out += '\n';
+    }
+}
+
+ShaderProgramSource ShaderPreprocessor::Preprocess(const std::string& filepath, const std::vector<std::string>& defines)
+{
+    MappedFile file(filepath);
+    if (!file.IsOpen())
+    {
+        std::cout << "Shader: can't open " << filepath << std::endl;
+        return {};
+    }
+
+    const std::string path = std::filesystem::path(filepath).lexically_normal().string();
+    const uint64_t contentHash = Fnv1a(s_FnvBasis, file.GetText());
+    // one entry per file and defines, a changed file replaces its old entry
+    uint64_t key = Fnv1a(s_FnvBasis, path);
+    for (const std::string& define : defines)
+        key = Fnv1a(Fnv1a(key, define), std::string_view("\n", 1));
+
+    {
+        std::lock_guard<std::mutex> lock(s_Mutex);
+        auto it = s_Cache.find(key);
+        if (it != s_Cache.end() && it->second.contentHash == contentHash)
+        {
+            bool valid = true;
+            for (const auto& include : it->second.includes)
+            {
+                MappedFile includeFile(include.first);
+                if (!includeFile.IsOpen() || Fnv1a(s_FnvBasis, includeFile.GetText()) != include.second)
+                {
+                    valid = false;
+                    break;
+                }
+            }
+            if (valid)
+            {
+                s_Hits++;
+                return it->second.source;
+            }
+        }
+        s_Misses++;
+    }
+
+    ShaderProgramSource source;
+    source.Files.push_back(path);
+    PreprocessContext context = { source, defines };
+    context.hashes.push_back(contentHash);
+    PreprocessFile(context, file.GetText(), 0, 0);
+
+    // every stage starts with its #version, the defines and a #line to its first line in the file,
+    // so error line numbers are file lines whichever of these a stage has
+    for (int stage = 0; stage < (int)ShaderStage::Count; stage++)
+    {
+        std::string& out = source.Get((ShaderStage)stage);
+        if (out.empty())
+            continue;
+        std::string prefix;
+        if (!context.versions[stage].empty())
+        {
+            prefix += context.versions[stage];
+            prefix += '\n';
+        }
+        AppendDefines(prefix, defines);
+        AppendLine(prefix, context.firstLines[stage], 0);
+        out.insert(0, prefix);
+    }
+
+    CacheEntry entry;
+    entry.source = source;
+    entry.contentHash = contentHash;
+    for (size_t i = 1; i < source.Files.size(); i++)
+        entry.includes.push_back({ source.Files[i], context.hashes[i] });
+
+    std::lock_guard<std::mutex> lock(s_Mutex);
+    s_Cache[key] = std::move(entry);
+    return source;
+}
+
+const char* ShaderPreprocessor::GetStageName(ShaderStage stage)
+{
+    switch (stage)
+    {
+    case ShaderStage::Vertex:           return "vertex";
+    case ShaderStage::Fragment:         return "fragment";
+    case ShaderStage::Geometry:         return "geometry";
+    case ShaderStage::TessControl:      return "tess_control";
+    case ShaderStage::TessEvaluation:   return "tess_evaluation";
+    case ShaderStage::Compute:          return "compute";
+    default:                            return "?";
+    }
+}
+
+void ShaderPreprocessor::ClearCache()
+{
+    std::lock_guard<std::mutex> lock(s_Mutex);
+    s_Cache.clear();
+}
+
+unsigned int ShaderPreprocessor::GetCacheHitCount()
+{
+    std::lock_guard<std::mutex> lock(s_Mutex);
+    return s_Hits;
+}
+
+unsigned int ShaderPreprocessor::GetCacheMissCount()
+{
+    std::lock_guard<std::mutex> lock(s_Mutex);
+    return s_Misses;
+}
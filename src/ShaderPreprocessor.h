@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+enum class ShaderStage
+{
+	Vertex, Fragment, Geometry, TessControl, TessEvaluation, Compute, Count
+};
+
+// struct to store shader files, stages without source aren't part of the program
+struct ShaderProgramSource
+{
+	std::string VertexSource;
+	std::string FragmentSource;
+	std::string GeometrySource;
+	std::string TessControlSource;
+	std::string TessEvaluationSource;
+	std::string ComputeSource;
+	// the .shader file, then everything it included. Compile errors in an include report its
+	// index here as the source string number ("2:14(3): error ...")
+	std::vector<std::string> Files;
+
+	std::string& Get(ShaderStage stage)
+	{
+		switch (stage)
+		{
+		case ShaderStage::Vertex:			return VertexSource;
+		case ShaderStage::Fragment:			return FragmentSource;
+		case ShaderStage::Geometry:			return GeometrySource;
+		case ShaderStage::TessControl:		return TessControlSource;
+		case ShaderStage::TessEvaluation:	return TessEvaluationSource;
+		default:							return ComputeSource;
+		}
+	}
+
+	const std::string& Get(ShaderStage stage) const
+	{
+		return const_cast<ShaderProgramSource*>(this)->Get(stage);
+	}
+};
+
+// Turns a .shader file into per-stage GLSL in one pass over the memory-mapped file:
+//   #shader vertex|fragment|geometry|tess_control|tess_evaluation|compute   starts a stage
+//   #include "file"   pasted in place, relative to the including file, once per stage
+// Each stage starts with its #version (moved up from wherever it was, includes too), the defines
+// ("NAME" or "NAME VALUE") as #defines and a #line, so compile errors always report real file lines.
+// Results are cached per file and defines, checked against the content hash of the file and its
+// includes, so loading the same shader again (variants, reloads of an untouched file) only maps and
+// hashes the files.
+class ShaderPreprocessor
+{
+private:
+	struct CacheEntry
+	{
+		ShaderProgramSource source;
+		uint64_t contentHash;
+		// includes and their content hashes, the entry is stale if any of them changed
+		std::vector<std::pair<std::string, uint64_t>> includes;
+	};
+
+	static std::mutex s_Mutex;
+	static std::unordered_map<uint64_t, CacheEntry> s_Cache;
+	static unsigned int s_Hits;
+	static unsigned int s_Misses;
+public:
+	// thread safe, doesn't touch GL. Missing files and unknown stages are printed, what could be
+	// read is returned anyway
+	static ShaderProgramSource Preprocess(const std::string& filepath, const std::vector<std::string>& defines = {});
+
+	static const char* GetStageName(ShaderStage stage);
+
+	static void ClearCache();
+	static unsigned int GetCacheHitCount();
+	static unsigned int GetCacheMissCount();
+};
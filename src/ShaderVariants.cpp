@@ -0,0 +1,58 @@
+#include "ShaderVariants.h"
+
+#include "Renderer.h"
+
+ShaderVariants::ShaderVariants(const std::string& filepath, const std::vector<std::string>& keywords)
+    : m_FilePath(filepath), m_Keywords(keywords)
+{
+    ASSERT(keywords.size() <= s_MaxKeywords);
+}
+
+uint64_t ShaderVariants::GetMask(const std::string& keyword) const
+{
+    for (size_t i = 0; i < m_Keywords.size(); i++)
+    {
+        if (m_Keywords[i] == keyword)
+            return 1ull << i;
+    }
+    return 0;
+}
+
+uint64_t ShaderVariants::Normalize(uint64_t mask) const
+{
+    if (m_Keywords.size() < s_MaxKeywords)
+        mask &= (1ull << m_Keywords.size()) - 1;
+    return mask;
+}
+
+bool ShaderVariants::IsReady(uint64_t mask) const
+{
+    auto it = m_Variants.find(Normalize(mask));
+    return it != m_Variants.end() && it->second->IsReady();
+}
+
+Shader& ShaderVariants::Get(uint64_t mask)
+{
+    mask = Normalize(mask);
+    auto it = m_Variants.find(mask);
+    if (it != m_Variants.end())
+        return *it->second;
+
+    // always in bit order, so the same variant always preprocesses to the same source (and cache keys)
+    std::vector<std::string> defines;
+    for (size_t i = 0; i < m_Keywords.size(); i++)
+    {
+        if (mask & (1ull << i))
+            defines.push_back(m_Keywords[i] + " 1");
+    }
+
+    std::unique_ptr<Shader>& shader = m_Variants[mask];
+    shader = std::make_unique<Shader>(m_FilePath, defines);
+    return *shader;
+}
+
+void ShaderVariants::Prepare(const std::vector<uint64_t>& masks)
+{
+    for (uint64_t mask : masks)
+        Get(mask);
+}
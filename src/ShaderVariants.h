@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Shader.h"
+
+// All variants of one .shader file, selected by a keyword bitmask:
+//   ShaderVariants lit("res/shaders/Lit.shader", { "SKINNED", "FOG" });
+//   Shader& shader = lit.Get(lit.GetMask("SKINNED") | lit.GetMask("FOG"));
+// Bit i of the mask adds "#define <keyword i> 1" (ShaderPreprocessor), so the shader can use #ifdef
+// or #if. A variant is compiled the first time it's asked for and kept, combinations nobody uses
+// never reach the driver. With the ProgramBinaryCache a variant that was used before is only a
+// binary upload, with Shader::SetAsyncCompilation the Renderer draws the placeholder until it's ready.
+class ShaderVariants
+{
+private:
+	std::string m_FilePath;
+	std::vector<std::string> m_Keywords;
+	// by mask. Shaders stay where they are, ShaderHotReload holds on to them
+	std::unordered_map<uint64_t, std::unique_ptr<Shader>> m_Variants;
+public:
+	static const unsigned int s_MaxKeywords = 64;
+
+	ShaderVariants(const std::string& filepath, const std::vector<std::string>& keywords);
+
+	// 0 for keywords that weren't declared
+	uint64_t GetMask(const std::string& keyword) const;
+	// drops the bits without a keyword, they would only make duplicates
+	uint64_t Normalize(uint64_t mask) const;
+
+	// compiles the variant on first use
+	Shader& Get(uint64_t mask);
+	// start compiling variants that will be needed soon, e.g. during a loading screen
+	void Prepare(const std::vector<uint64_t>& masks);
+	// the variant was asked for (Get/Prepare), it may still be compiling
+	inline bool HasVariant(uint64_t mask) const { return m_Variants.find(Normalize(mask)) != m_Variants.end(); }
+	// the variant was asked for and is linked, false while compiling or if it failed
+	bool IsReady(uint64_t mask) const;
+
+	inline const std::string& GetFilePath() const { return m_FilePath; }
+	inline unsigned int GetVariantCount() const { return (unsigned int)m_Variants.size(); }
+};
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+#include "VertexBufferLayout.h"
+#include "VertexArray.h"
+
+// Compile-time counterpart of VertexBufferLayout:
+//   using Layout = StaticLayout<Attr<float, 3>, Attr<unsigned char, 4, Normalized>>;
+//   va.AddBuffer(vb, Layout());
+// Stride, offsets and the element array are constexpr, so AddBuffer doesn't allocate, and vertex
+// structs can be checked against the layout, the size and every member on its own:
+//   static_assert(Layout::MatchesStride<Vertex>());
+//   static_assert(Layout::Offsets[0] == offsetof(Vertex, position));
+//   static_assert(Layout::Offsets[1] == offsetof(Vertex, color));
+
+enum AttrFlags : unsigned int
+{
+	// integer data shows up as [0, 1] / [-1, 1] floats in the shader
+	Normalized = 1 << 0,
+	// advances once per instance instead of once per vertex
+	PerInstance = 1 << 1
+};
+
+// GL type and byte size of one component
+template<typename T>
+struct AttrType;
+
+template<> struct AttrType<float>				{ static constexpr unsigned int gl = GL_FLOAT;				static constexpr unsigned int size = 4; };
+template<> struct AttrType<unsigned int>		{ static constexpr unsigned int gl = GL_UNSIGNED_INT;		static constexpr unsigned int size = 4; };
+template<> struct AttrType<unsigned char>		{ static constexpr unsigned int gl = GL_UNSIGNED_BYTE;		static constexpr unsigned int size = 1; };
+template<> struct AttrType<Half>				{ static constexpr unsigned int gl = GL_HALF_FLOAT;			static constexpr unsigned int size = 2; };
+template<> struct AttrType<short>				{ static constexpr unsigned int gl = GL_SHORT;				static constexpr unsigned int size = 2; };
+template<> struct AttrType<unsigned short>		{ static constexpr unsigned int gl = GL_UNSIGNED_SHORT;		static constexpr unsigned int size = 2; };
+// all 4 components share one word
+template<> struct AttrType<PackedInt2101010>	{ static constexpr unsigned int gl = GL_INT_2_10_10_10_REV;	static constexpr unsigned int size = 0; };
+
+template<typename T, unsigned int Count, unsigned int Flags = 0>
+struct Attr
+{
+	static_assert(Count >= 1, "attributes need at least one component");
+	static_assert(AttrType<T>::size != 0 || Count == 4, "packed 2_10_10_10 attributes are always vec4");
+
+	using Type = T;
+	static constexpr unsigned int count = Count;
+	static constexpr unsigned int size = AttrType<T>::size != 0 ? AttrType<T>::size * Count : 4;
+	static constexpr VertexBufferElement element = {
+		AttrType<T>::gl, Count, (unsigned char)((Flags & Normalized) ? GL_TRUE : GL_FALSE), (Flags & PerInstance) ? 1u : 0u
+	};
+};
+
+template<typename... Attrs>
+struct StaticLayout
+{
+	static_assert(sizeof...(Attrs) > 0, "empty layout");
+
+	static constexpr unsigned int Count = sizeof...(Attrs);
+	static constexpr unsigned int Stride = (Attrs::size + ...);
+	static constexpr std::array<VertexBufferElement, Count> Elements = { { Attrs::element... } };
+
+	static constexpr std::array<unsigned int, Count> Offsets = []()
+	{
+		std::array<unsigned int, Count> offsets = {};
+		const unsigned int sizes[] = { Attrs::size... };
+		unsigned int offset = 0;
+		for (unsigned int i = 0; i < Count; i++)
+		{
+			offsets[i] = offset;
+			offset += sizes[i];
+		}
+		return offsets;
+	}();
+
+	// only sizeof(Vertex) == Stride, reordered or retyped members of the same total size still pass.
+	// Check each member with Offsets and offsetof as well
+	template<typename Vertex>
+	static constexpr bool MatchesStride() { return sizeof(Vertex) == Stride; }
+};
+
+template<typename... Attrs>
+void VertexArray::AddBuffer(const VertexBuffer& vb, const StaticLayout<Attrs...>&)
+{
+	using Layout = StaticLayout<Attrs...>;
+	AddElements(vb, Layout::Elements.data(), Layout::Count, Layout::Stride);
+}
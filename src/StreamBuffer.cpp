@@ -0,0 +1,77 @@
+#include "StreamBuffer.h"
+
+#include "Renderer.h"
+
+StreamBuffer::StreamBuffer(unsigned int regionSize, unsigned int regions)
+    : m_Buffer(nullptr, regionSize * regions, BufferUsage::Persistent),
+      m_RegionSize(regionSize), m_RegionCount(regions), m_Region(0), m_Used(0),
+      m_Fences(regions, nullptr)
+{
+}
+
+StreamBuffer::~StreamBuffer()
+{
+    for (GLsync fence : m_Fences)
+    {
+        if (fence)
+        {
+            GLCall(glDeleteSync(fence));
+        }
+    }
+}
+
+void* StreamBuffer::Map(unsigned int size, unsigned int& offset, unsigned int alignment)
+{
+    unsigned int regionStart = m_Region * m_RegionSize;
+    unsigned int start = regionStart + m_Used;
+    // round up in absolute terms so offset / stride is a whole vertex
+    if (alignment > 1)
+        start = (start + alignment - 1) / alignment * alignment;
+
+    if (start + size > regionStart + m_RegionSize)
+        return nullptr;
+
+    m_Used = start + size - regionStart;
+    offset = start;
+
+    return m_Buffer.Map(start, size);
+}
+
+void StreamBuffer::Unmap()
+{
+    m_Buffer.Unmap();
+}
+
+void StreamBuffer::Advance()
+{
+    // everything drawn from this region so far has to finish before we write it again
+    if (m_Fences[m_Region])
+    {
+        GLCall(glDeleteSync(m_Fences[m_Region]));
+    }
+    GLCall(m_Fences[m_Region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+
+    m_Region = (m_Region + 1) % m_RegionCount;
+    m_Used = 0;
+    WaitForRegion(m_Region);
+}
+
+void StreamBuffer::WaitForRegion(unsigned int region)
+{
+    GLsync fence = m_Fences[region];
+    if (!fence)
+        return;
+
+    // the first wait flushes so the fence is guaranteed to signal eventually
+    GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+    for (;;)
+    {
+        GLCall(GLenum result = glClientWaitSync(fence, flags, 1000000));
+        if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED || result == GL_WAIT_FAILED)
+            break;
+        flags = 0;
+    }
+
+    GLCall(glDeleteSync(fence));
+    m_Fences[region] = nullptr;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <vector>
+#include <GL/glew.h>
+
+#include "VertexBuffer.h"
+
+// Ring of per-frame regions in one persistently mapped vertex buffer, for geometry
+// that is rewritten every frame (particles, UI). Map hands out space in the current
+// frame's region; Advance fences that region and moves on, waiting only if the GPU
+// is still reading the region we come back to (regions frames later).
+//
+//   unsigned int offset;
+//   Vertex* v = (Vertex*)stream.Map(count * sizeof(Vertex), offset, sizeof(Vertex));
+//   ... fill v ...
+//   stream.Unmap();
+//   renderer.DrawRange(va, ib, shader, { indexCount, 0, (int)(offset / sizeof(Vertex)) });
+//   stream.Advance();   // once per frame
+//
+// Without persistent mapping (no GL 4.4 / ARB_buffer_storage) Map/Unmap fall back to
+// glMapBufferRange on the region, the fences still keep us off ranges in flight.
+class StreamBuffer
+{
+private:
+	VertexBuffer m_Buffer;
+	unsigned int m_RegionSize;
+	unsigned int m_RegionCount;
+	unsigned int m_Region;
+	// bytes used in the current region
+	unsigned int m_Used;
+	std::vector<GLsync> m_Fences;
+public:
+	// regionSize - bytes available per frame, regions - frames in flight (3 = triple buffering)
+	StreamBuffer(unsigned int regionSize, unsigned int regions = 3);
+	~StreamBuffer();
+
+	StreamBuffer(const StreamBuffer&) = delete;
+	StreamBuffer& operator=(const StreamBuffer&) = delete;
+
+	// size bytes from the current region, offset receives the absolute byte offset in
+	// the buffer (a multiple of alignment, pass the vertex stride to use it as base vertex).
+	// nullptr if the region is full.
+	void* Map(unsigned int size, unsigned int& offset, unsigned int alignment = 4);
+	// done writing the last Map, before drawing from it
+	void Unmap();
+	// end of frame
+	void Advance();
+
+	inline const VertexBuffer& GetBuffer() const { return m_Buffer; }
+	inline bool IsPersistent() const { return m_Buffer.GetPersistentPointer() != nullptr; }
+private:
+	void WaitForRegion(unsigned int region);
+};
@@ -1,46 +1,227 @@
 #include "VertexArray.h"
+
+#include <algorithm>
+#include <cstdint>
+
 #include "VertexBufferLayout.h"
 
 #include "Renderer.h"
+#include "DeletionQueue.h"
 
 VertexArray::VertexArray()
+	: m_AttribCount(0), m_BindingCount(0), m_StreamCount(0)
 {
-
-};
+	if (Renderer::UseDirectStateAccess())
+	{
+		GLCall(glCreateVertexArrays(1, &m_RendererID));
+	}
+	else
+	{
+		GLCall(glGenVertexArrays(1, &m_RendererID));
+	}
+}
 
 VertexArray::~VertexArray()
 {
+	DeletionQueue::Enqueue(GLObjectType::VertexArray, m_RendererID);
+}
+
+VertexArray::VertexArray(VertexArray&& other) noexcept
+	: m_RendererID(other.m_RendererID), m_AttribCount(other.m_AttribCount), m_BindingCount(other.m_BindingCount),
+	  m_StreamCount(other.m_StreamCount)
+{
+	std::copy(other.m_Attribs, other.m_Attribs + m_AttribCount, m_Attribs);
+	std::copy(other.m_Bindings, other.m_Bindings + m_BindingCount, m_Bindings);
+	other.m_RendererID = 0;
+	other.m_AttribCount = 0;
+	other.m_BindingCount = 0;
+	other.m_StreamCount = 0;
+}
+
+VertexArray& VertexArray::operator=(VertexArray&& other) noexcept
+{
+	if (this != &other)
+	{
+		DeletionQueue::Enqueue(GLObjectType::VertexArray, m_RendererID);
+		m_RendererID = other.m_RendererID;
+		m_AttribCount = other.m_AttribCount;
+		m_BindingCount = other.m_BindingCount;
+		m_StreamCount = other.m_StreamCount;
+		std::copy(other.m_Attribs, other.m_Attribs + m_AttribCount, m_Attribs);
+		std::copy(other.m_Bindings, other.m_Bindings + m_BindingCount, m_Bindings);
+		other.m_RendererID = 0;
+		other.m_AttribCount = 0;
+		other.m_BindingCount = 0;
+		other.m_StreamCount = 0;
+	}
+	return *this;
+}
 
-};
+bool VertexArray::SupportsAttribBinding()
+{
+	return GLEW_VERSION_4_3 || GLEW_ARB_vertex_attrib_binding;
+}
 
 void VertexArray::AddBuffer(const VertexBuffer& vb, const VertexBufferLayout& layout)
 {
-	vb.Bind();
 	const auto& elements = layout.GetElements();
+	AddElements(vb, elements.data(), (unsigned int)elements.size(), layout.GetStride());
+}
+
+void VertexArray::AddElements(const VertexBuffer& vb, const VertexBufferElement* elements, unsigned int elementCount, unsigned int stride)
+{
+	const unsigned int stream = m_StreamCount++;
+
+	// DSA edits the VAO by name, nothing gets bound
+	const bool dsa = Renderer::UseDirectStateAccess();
+	if (!dsa)
+		Bind();
+	const bool attribBinding = SupportsAttribBinding();
 	unsigned int offset = 0;
+	unsigned int binding = 0;
 
 	// Loop through elements
-	for (unsigned int i = 0; i < elements.size(); i++)
+	for (unsigned int i = 0; i < elementCount; i++)
 	{
 		const auto& element = elements[i];
 
-		// Enable vertex attribute array
-		glEnableVertexAttribArray(i);
+		// The divisor belongs to the binding, so a layout that mixes per-vertex and per-instance
+		// elements gets one binding per run of equal divisors, all reading the same buffer
+		if (i == 0 || element.divisor != elements[i - 1].divisor)
+		{
+			if (i > 0)
+				FinishBinding(binding, vb);
+			ASSERT(m_BindingCount < s_MaxBindings);
+			binding = m_BindingCount++;
+			m_Bindings[binding] = { stride, element.divisor, m_AttribCount, 0, stream };
+		}
 
-		// Set vertex attribute pointer
-		glVertexAttribPointer(i, element.count, element.type, element.normalized, layout.GetStride(), (const void*)offset);
+		unsigned int typeSize = VertexBufferElement::GetSizeOfType(element.type);
+
+		// attributes hold at most 4 components, bigger elements (mat4) take consecutive locations
+		for (unsigned int component = 0; component < element.count; component += 4)
+		{
+			ASSERT(m_AttribCount < s_MaxAttribs);
+			unsigned int count = element.count - component < 4 ? element.count - component : 4;
+			unsigned int relativeOffset = offset + component * typeSize;
+			m_Attribs[m_AttribCount] = { element.type, count, element.normalized, relativeOffset };
+
+			if (dsa)
+			{
+				GLCall(glEnableVertexArrayAttrib(m_RendererID, m_AttribCount));
+				GLCall(glVertexArrayAttribFormat(m_RendererID, m_AttribCount, count, element.type, element.normalized, relativeOffset));
+				GLCall(glVertexArrayAttribBinding(m_RendererID, m_AttribCount, binding));
+				m_AttribCount++;
+				continue;
+			}
+
+			// Enable vertex attribute array
+			GLCall(glEnableVertexAttribArray(m_AttribCount));
+
+			// the format is set once, the buffer comes later in BindBufferToSlot
+			if (attribBinding)
+			{
+				GLCall(glVertexAttribFormat(m_AttribCount, count, element.type, element.normalized, relativeOffset));
+				GLCall(glVertexAttribBinding(m_AttribCount, binding));
+			}
+			else if (element.divisor != 0)
+			{
+				// per-instance stream
+				GLCall(glVertexAttribDivisor(m_AttribCount, element.divisor));
+			}
+
+			m_AttribCount++;
+		}
 
 		// Increment offset
-		offset += element.count * VertexBufferElement::GetSizeOfType(element.type);
+		offset += VertexBufferElement::GetSizeOfElement(element.type, element.count);
+	}
+
+	if (elementCount > 0)
+		FinishBinding(binding, vb);
+}
+
+void VertexArray::FinishBinding(unsigned int binding, const VertexBuffer& vb)
+{
+	m_Bindings[binding].attribCount = m_AttribCount - m_Bindings[binding].firstAttrib;
+
+	if (Renderer::UseDirectStateAccess())
+	{
+		GLCall(glVertexArrayBindingDivisor(m_RendererID, binding, m_Bindings[binding].divisor));
+	}
+	else if (SupportsAttribBinding())
+	{
+		GLCall(glVertexBindingDivisor(binding, m_Bindings[binding].divisor));
+	}
+	BindBufferToSlot(binding, vb);
+}
+
+void VertexArray::SetVertexBuffer(unsigned int stream, const VertexBuffer& vb)
+{
+	ASSERT(stream < m_StreamCount);
+	if (!Renderer::UseDirectStateAccess())
+		Bind();
+	for (unsigned int binding = 0; binding < m_BindingCount; binding++)
+	{
+		if (m_Bindings[binding].stream == stream)
+			BindBufferToSlot(binding, vb);
+	}
+}
+
+unsigned int VertexArray::GetFirstAttrib(unsigned int stream) const
+{
+	for (unsigned int binding = 0; binding < m_BindingCount; binding++)
+	{
+		if (m_Bindings[binding].stream == stream)
+			return m_Bindings[binding].firstAttrib;
+	}
+	return m_AttribCount;
+}
+
+unsigned int VertexArray::GetStreamAttribCount(unsigned int stream) const
+{
+	unsigned int count = 0;
+	for (unsigned int binding = 0; binding < m_BindingCount; binding++)
+	{
+		if (m_Bindings[binding].stream == stream)
+			count += m_Bindings[binding].attribCount;
+	}
+	return count;
+}
+
+void VertexArray::BindBufferToSlot(unsigned int binding, const VertexBuffer& vb)
+{
+	// arena views start somewhere inside their buffer
+	if (Renderer::UseDirectStateAccess())
+	{
+		GLCall(glVertexArrayVertexBuffer(m_RendererID, binding, vb.GetRendererID(), vb.GetOffset(), m_Bindings[binding].stride));
+		return;
+	}
+	if (SupportsAttribBinding())
+	{
+		GLCall(glBindVertexBuffer(binding, vb.GetRendererID(), vb.GetOffset(), m_Bindings[binding].stride));
+		return;
+	}
+
+	// no separate format state, every attribute of the binding has to be pointed at the new buffer
+	vb.Bind();
+	const Binding& slot = m_Bindings[binding];
+	for (unsigned int i = slot.firstAttrib; i < slot.firstAttrib + slot.attribCount; i++)
+	{
+		const AttribFormat& format = m_Attribs[i];
+
+		// Set vertex attribute pointer
+		GLCall(glVertexAttribPointer(i, format.count, format.type, format.normalized, slot.stride,
+			(const void*)(uintptr_t)(vb.GetOffset() + format.relativeOffset)));
 	}
 }
 
 void VertexArray::Bind() const
 {
-	GLCall(glBindVertexArray(0));
+	RenderState::BindVertexArray(m_RendererID);
 }
 
 void VertexArray::Unbind() const
 {
-	GLCall(glBindVertexArray(0));
+	RenderState::BindVertexArray(0);
 }
@@ -3,17 +3,86 @@
 #include "VertexBuffer.h"
 
 class VertexBufferLayout;
+struct VertexBufferElement;
+template<typename... Attrs>
+struct StaticLayout;
 
+// Owns a VAO. Every AddBuffer call adds a stream with its own buffer binding slot (two or more if
+// its layout mixes per-vertex and per-instance elements), and the attribute formats are kept
+// separate from the buffer (ARB_vertex_attrib_binding where available, re-pointed attributes
+// otherwise), so SetVertexBuffer can swap in another buffer with the same layout.
 class VertexArray
 {
 private:
+	// GL only guarantees 16 attributes and 16 bindings
+	static const unsigned int s_MaxAttribs = 16;
+	static const unsigned int s_MaxBindings = 16;
 
+	struct AttribFormat
+	{
+		unsigned int type;
+		unsigned int count;
+		unsigned char normalized;
+		unsigned int relativeOffset;
+	};
+
+	struct Binding
+	{
+		unsigned int stride;
+		unsigned int divisor;
+		// attribute locations firstAttrib .. firstAttrib + attribCount - 1
+		unsigned int firstAttrib;
+		unsigned int attribCount;
+		// the AddBuffer call it came from
+		unsigned int stream;
+	};
+
+	unsigned int m_RendererID;
+	// next free attribute location, every AddBuffer continues where the last one stopped
+	unsigned int m_AttribCount;
+	unsigned int m_BindingCount;
+	unsigned int m_StreamCount;
+	AttribFormat m_Attribs[s_MaxAttribs];
+	Binding m_Bindings[s_MaxBindings];
+
+	void AddElements(const VertexBuffer& vb, const VertexBufferElement* elements, unsigned int elementCount, unsigned int stride);
+	// divisor + buffer once all attributes of the binding are set up
+	void FinishBinding(unsigned int binding, const VertexBuffer& vb);
+	void BindBufferToSlot(unsigned int binding, const VertexBuffer& vb);
 public:
 	VertexArray();
 	~VertexArray();
 
+	// move-only, see VertexBuffer
+	VertexArray(const VertexArray&) = delete;
+	VertexArray& operator=(const VertexArray&) = delete;
+	VertexArray(VertexArray&& other) noexcept;
+	VertexArray& operator=(VertexArray&& other) noexcept;
+
+	// glVertexAttribFormat/glBindVertexBuffer (GL 4.3 or ARB_vertex_attrib_binding)
+	static bool SupportsAttribBinding();
+
+	// Every call adds a stream: its attributes take the next free locations (see GetFirstAttrib),
+	// so a position stream + attribute stream (SplitPositionStream) or per-vertex and per-instance
+	// (VertexBufferLayout::PushInstanced) buffers can be mixed, also within one layout.
 	void AddBuffer(const VertexBuffer& vb, const VertexBufferLayout& layout);
+	// compile-time layout, no allocation. Defined in StaticLayout.h
+	template<typename... Attrs>
+	void AddBuffer(const VertexBuffer& vb, const StaticLayout<Attrs...>& layout);
+
+	// points stream (the n-th AddBuffer call) at another buffer with the same layout, e.g. to switch meshes
+	// without another VAO. Only a buffer rebind on the attrib binding path.
+	void SetVertexBuffer(unsigned int stream, const VertexBuffer& vb);
 
 	void Bind() const;
 	void Unbind() const;
+
+	inline unsigned int GetRendererID() const { return m_RendererID; }
+	// GL buffer binding slots, at least one per stream
+	inline unsigned int GetBindingCount() const { return m_BindingCount; }
+	inline unsigned int GetStreamCount() const { return m_StreamCount; }
+	inline unsigned int GetAttribCount() const { return m_AttribCount; }
+	// first attribute location of the stream added by the stream-th AddBuffer call
+	unsigned int GetFirstAttrib(unsigned int stream) const;
+	unsigned int GetStreamAttribCount(unsigned int stream) const;
 };
\ No newline at end of file
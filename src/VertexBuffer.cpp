@@ -1,25 +1,189 @@
 #include "VertexBuffer.h"
 
+#include <cstring>
+
 #include "Renderer.h"
+#include "DeletionQueue.h"
 
-VertexBuffer::VertexBuffer(const void* data, unsigned int size)
+static GLenum ToGLUsage(BufferUsage usage)
 {
+    switch (usage)
+    {
+    case BufferUsage::Dynamic:    return GL_DYNAMIC_DRAW;
+    case BufferUsage::Stream:     return GL_STREAM_DRAW;
+    case BufferUsage::Persistent: return GL_DYNAMIC_DRAW;
+    default:                      return GL_STATIC_DRAW;
+    }
+}
+
+VertexBuffer::VertexBuffer(const void* data, unsigned int size, BufferUsage usage)
+    : m_Size(size), m_Usage(usage), m_PersistentPtr(nullptr), m_Arena(nullptr), m_Allocation{ 0, 0, 0, size }
+{
+    const bool persistent = usage == BufferUsage::Persistent && (GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage);
+    // coherent, so writes become visible without explicit flushes; fences do the rest
+    const GLbitfield persistentFlags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+    if (Renderer::UseDirectStateAccess())
+    {
+        GLCall(glCreateBuffers(1, &m_RendererID));
+        if (size == 0)
+            return;
+
+        if (persistent)
+        {
+            GLCall(glNamedBufferStorage(m_RendererID, (GLsizeiptr)size, data, persistentFlags));
+            GLCall(m_PersistentPtr = glMapNamedBufferRange(m_RendererID, 0, (GLsizeiptr)size, persistentFlags));
+        }
+        else if (usage == BufferUsage::Static)
+        {
+            // immutable, SubData and Map still allowed like on the glBufferData path
+            GLCall(glNamedBufferStorage(m_RendererID, (GLsizeiptr)size, data, GL_DYNAMIC_STORAGE_BIT | GL_MAP_WRITE_BIT));
+        }
+        else
+        {
+            // dynamic/stream data stays mutable so it can be orphaned
+            GLCall(glNamedBufferData(m_RendererID, (GLsizeiptr)size, data, ToGLUsage(usage)));
+        }
+        return;
+    }
+
     GLCall(glGenBuffers(1, &m_RendererID));
-    GLCall(glBindBuffer(GL_ARRAY_BUFFER, m_RendererID));
-    GLCall(glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)size, data, GL_STATIC_DRAW));
+    RenderState::BindBuffer(GL_ARRAY_BUFFER, m_RendererID);
+
+    if (persistent)
+    {
+        GLCall(glBufferStorage(GL_ARRAY_BUFFER, (GLsizeiptr)size, data, persistentFlags));
+        GLCall(m_PersistentPtr = glMapBufferRange(GL_ARRAY_BUFFER, 0, (GLsizeiptr)size, persistentFlags));
+        return;
+    }
+
+    GLCall(glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)size, data, ToGLUsage(usage)));
+}
+
+VertexBuffer::VertexBuffer(BufferArena& arena, const void* data, unsigned int size, unsigned int alignment)
+    : m_Size(size), m_Usage(BufferUsage::Static), m_PersistentPtr(nullptr), m_Arena(&arena)
+{
+    m_Allocation = arena.Allocate(size, alignment);
+    m_RendererID = m_Allocation.buffer;
+    if (data)
+        arena.Upload(m_Allocation, data, size);
 }
 
 VertexBuffer::~VertexBuffer()
 {
-    GLCall(glDeleteBuffers(1, &m_RendererID));
+    Release();
+}
+
+VertexBuffer::VertexBuffer(VertexBuffer&& other) noexcept
+    : m_RendererID(other.m_RendererID), m_Size(other.m_Size), m_Usage(other.m_Usage),
+      m_PersistentPtr(other.m_PersistentPtr), m_Arena(other.m_Arena), m_Allocation(other.m_Allocation)
+{
+    other.m_RendererID = 0;
+    other.m_Size = 0;
+    other.m_PersistentPtr = nullptr;
+    other.m_Arena = nullptr;
+    other.m_Allocation = { 0, 0, 0, 0 };
+}
+
+VertexBuffer& VertexBuffer::operator=(VertexBuffer&& other) noexcept
+{
+    if (this != &other)
+    {
+        Release();
+        m_RendererID = other.m_RendererID;
+        m_Size = other.m_Size;
+        m_Usage = other.m_Usage;
+        m_PersistentPtr = other.m_PersistentPtr;
+        m_Arena = other.m_Arena;
+        m_Allocation = other.m_Allocation;
+
+        other.m_RendererID = 0;
+        other.m_Size = 0;
+        other.m_PersistentPtr = nullptr;
+        other.m_Arena = nullptr;
+        other.m_Allocation = { 0, 0, 0, 0 };
+    }
+    return *this;
+}
+
+void VertexBuffer::Release()
+{
+    if (m_Arena)
+    {
+        // the range may still be read by queued draws, same as a buffer of its own
+        DeletionQueue::EnqueueFree(*m_Arena, m_Allocation);
+        m_Arena = nullptr;
+    }
+    else if (m_RendererID)
+    {
+        // persistent mappings go away with the buffer
+        DeletionQueue::Enqueue(GLObjectType::Buffer, m_RendererID);
+    }
+    m_RendererID = 0;
+    m_PersistentPtr = nullptr;
 }
 
 void VertexBuffer::Bind() const
 {
-    GLCall(glBindBuffer(GL_ARRAY_BUFFER, m_RendererID));
+    RenderState::BindBuffer(GL_ARRAY_BUFFER, m_RendererID);
 }
 
 void VertexBuffer::Unbind() const
 {
-    GLCall(glBindBuffer(GL_ARRAY_BUFFER, 0));
+    RenderState::BindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void VertexBuffer::SubData(const void* data, unsigned int size, unsigned int offset)
+{
+    ASSERT(offset + size <= m_Size);
+    // persistent storage has no GL_DYNAMIC_STORAGE_BIT, glBufferSubData isn't allowed on it.
+    // The mapping is coherent, so a plain copy is all it takes
+    if (m_PersistentPtr)
+    {
+        std::memcpy((unsigned char*)m_PersistentPtr + offset, data, size);
+        return;
+    }
+
+    if (Renderer::UseDirectStateAccess())
+    {
+        GLCall(glNamedBufferSubData(m_RendererID, (GLintptr)(m_Allocation.offset + offset), (GLsizeiptr)size, data));
+        return;
+    }
+
+    Bind();
+    GLCall(glBufferSubData(GL_ARRAY_BUFFER, (GLintptr)(m_Allocation.offset + offset), (GLsizeiptr)size, data));
+}
+
+void* VertexBuffer::Map(unsigned int offset, unsigned int size)
+{
+    ASSERT(offset + size <= m_Size);
+    // invalidating a range of a shared arena block isn't something we want to do
+    ASSERT(!m_Arena);
+    if (m_PersistentPtr)
+        return (unsigned char*)m_PersistentPtr + offset;
+
+    if (Renderer::UseDirectStateAccess())
+    {
+        GLCall(void* ptr = glMapNamedBufferRange(m_RendererID, (GLintptr)offset, (GLsizeiptr)size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT));
+        return ptr;
+    }
+
+    Bind();
+    GLCall(void* ptr = glMapBufferRange(GL_ARRAY_BUFFER, (GLintptr)offset, (GLsizeiptr)size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT));
+    return ptr;
+}
+
+void VertexBuffer::Unmap()
+{
+    if (m_PersistentPtr)
+        return;
+
+    if (Renderer::UseDirectStateAccess())
+    {
+        GLCall(glUnmapNamedBuffer(m_RendererID));
+        return;
+    }
+
+    Bind();
+    GLCall(glUnmapBuffer(GL_ARRAY_BUFFER));
 }
@@ -1,13 +1,62 @@
 #pragma once
 
+#include "BufferArena.h"
+
+enum class BufferUsage
+{
+	// written once
+	Static,
+	// rewritten now and then through SubData/Map
+	Dynamic,
+	// rewritten every frame
+	Stream,
+	// immutable storage (glBufferStorage) mapped once for the buffer's whole life,
+	// see StreamBuffer. Falls back to Dynamic without GL 4.4 / ARB_buffer_storage.
+	Persistent
+};
+
 class VertexBuffer
 {
 private:
 	unsigned int m_RendererID;
+	unsigned int m_Size;
+	BufferUsage m_Usage;
+	// only set for Persistent buffers
+	void* m_PersistentPtr;
+	// set when this is a view into a shared arena buffer
+	BufferArena* m_Arena;
+	BufferAllocation m_Allocation;
+
+	void Release();
 public:
-	VertexBuffer(const void* data, unsigned int size);
+	// data may be nullptr to only allocate
+	VertexBuffer(const void* data, unsigned int size, BufferUsage usage = BufferUsage::Static);
+	// view into an arena block, no buffer object of its own. Static contents (SubData works, Map doesn't).
+	VertexBuffer(BufferArena& arena, const void* data, unsigned int size, unsigned int alignment = 16);
 	~VertexBuffer();
 
+	// move-only, the moved-from buffer is empty (id 0). VertexArrays and queued draws
+	// keep using the GL name / address they saw, so move before setting those up.
+	VertexBuffer(const VertexBuffer&) = delete;
+	VertexBuffer& operator=(const VertexBuffer&) = delete;
+	VertexBuffer(VertexBuffer&& other) noexcept;
+	VertexBuffer& operator=(VertexBuffer&& other) noexcept;
+
 	void Bind() const;
 	void Unbind() const;
-};
\ No newline at end of file
+
+	// update part of the buffer, a plain copy into the mapping for Persistent buffers
+	void SubData(const void* data, unsigned int size, unsigned int offset = 0);
+	// write-only mapping of [offset, offset + size), the old contents of the range are discarded.
+	// Any usage, but not arena views
+	void* Map(unsigned int offset, unsigned int size);
+	void Unmap();
+
+	inline unsigned int GetRendererID() const { return m_RendererID; }
+	// byte offset of this buffer's data inside the GL buffer object (non-zero for arena views)
+	inline unsigned int GetOffset() const { return m_Allocation.offset; }
+	inline unsigned int GetSize() const { return m_Size; }
+	inline BufferUsage GetUsage() const { return m_Usage; }
+	// coherent pointer to the whole buffer, nullptr unless the Persistent storage could be created
+	inline void* GetPersistentPointer() const { return m_PersistentPtr; }
+};
@@ -3,12 +3,15 @@
 #include <vector>
 #include <GL/glew.h>
 #include "Renderer.h"
+#include "VertexFormat.h"
 
 struct VertexBufferElement
 {
 	unsigned int type;
 	unsigned int count;
 	unsigned char normalized;
+	// 0 = per vertex, n = advance once every n instances
+	unsigned int divisor;
 
 	static unsigned int GetSizeOfType(unsigned int type)
 	{
@@ -16,11 +19,27 @@ struct VertexBufferElement
 		{
 		case GL_FLOAT:			return 4;
 		case GL_UNSIGNED_INT:	return 4;
+		case GL_HALF_FLOAT:		return 2;
+		case GL_SHORT:			return 2;
+		case GL_UNSIGNED_SHORT:	return 2;
 		case GL_UNSIGNED_BYTE:	return 1;
+		// the whole packed vec4
+		case GL_INT_2_10_10_10_REV:	return 4;
 		}
 		ASSERT(false);
 		return 0;
 	}
+
+	static bool IsPackedType(unsigned int type)
+	{
+		return type == GL_INT_2_10_10_10_REV;
+	}
+
+	// bytes one element of count components takes in the vertex
+	static unsigned int GetSizeOfElement(unsigned int type, unsigned int count)
+	{
+		return IsPackedType(type) ? GetSizeOfType(type) : GetSizeOfType(type) * count;
+	}
 };
 
 class VertexBufferLayout
@@ -32,32 +51,88 @@ public:
 	VertexBufferLayout() : m_Stride(0) {}
 
 	template<typename T>
-	void Push(unsigned int count)
-	{
-	}
+	void Push(unsigned int count);
 
-	template<>
-	void Push<float>(unsigned int count)
+	// per-instance attribute, e.g. PushInstanced<float>(16) for a mat4 transform. Can be mixed with
+	// per-vertex elements in one layout, VertexArray splits it into one binding per divisor run
+	template<typename T>
+	void PushInstanced(unsigned int count, unsigned int divisor = 1)
 	{
-		m_Elements.push_back({ GL_FLOAT, count, GL_FALSE });
-		m_Stride += VertexBufferElement::GetSizeOfType(GL_FLOAT) * count;
+		Push<T>(count);
+		m_Elements.back().divisor = divisor;
 	}
 
-	template<>
-	void Push<unsigned int>(unsigned int count)
+	// copies an element as is, for layouts derived from other layouts
+	void PushElement(const VertexBufferElement& element)
 	{
-		m_Elements.push_back({ GL_UNSIGNED_INT, count, GL_FALSE });
-		m_Stride += VertexBufferElement::GetSizeOfType(GL_UNSIGNED_INT) * count;
+		m_Elements.push_back(element);
+		m_Stride += VertexBufferElement::GetSizeOfElement(element.type, element.count);
 	}
 
-	template<>
-	void Push<unsigned char>(unsigned int count)
+	// byte offset of element index inside a vertex
+	unsigned int GetOffset(unsigned int index) const
 	{
-		m_Elements.push_back({ GL_UNSIGNED_BYTE, count, GL_TRUE });
-		m_Stride += VertexBufferElement::GetSizeOfType(GL_UNSIGNED_BYTE) * count;
+		unsigned int offset = 0;
+		for (unsigned int i = 0; i < index; i++)
+			offset += VertexBufferElement::GetSizeOfElement(m_Elements[i].type, m_Elements[i].count);
+		return offset;
 	}
 
 	inline const std::vector<VertexBufferElement>& GetElements() const { return m_Elements; }
 	inline unsigned int GetStride() const { return m_Stride; }
 
-};
\ No newline at end of file
+};
+
+// explicit specializations have to live at namespace scope (MSVC also accepts them in-class, GCC/Clang don't)
+template<>
+inline void VertexBufferLayout::Push<float>(unsigned int count)
+{
+	m_Elements.push_back({ GL_FLOAT, count, GL_FALSE, 0 });
+	m_Stride += VertexBufferElement::GetSizeOfType(GL_FLOAT) * count;
+}
+
+template<>
+inline void VertexBufferLayout::Push<unsigned int>(unsigned int count)
+{
+	m_Elements.push_back({ GL_UNSIGNED_INT, count, GL_FALSE, 0 });
+	m_Stride += VertexBufferElement::GetSizeOfType(GL_UNSIGNED_INT) * count;
+}
+
+template<>
+inline void VertexBufferLayout::Push<unsigned char>(unsigned int count)
+{
+	m_Elements.push_back({ GL_UNSIGNED_BYTE, count, GL_TRUE, 0 });
+	m_Stride += VertexBufferElement::GetSizeOfType(GL_UNSIGNED_BYTE) * count;
+}
+
+template<>
+inline void VertexBufferLayout::Push<Half>(unsigned int count)
+{
+	m_Elements.push_back({ GL_HALF_FLOAT, count, GL_FALSE, 0 });
+	m_Stride += VertexBufferElement::GetSizeOfType(GL_HALF_FLOAT) * count;
+}
+
+// shorts are always normalized, [-1, 1] / [0, 1] in the shader (see QuantizeSnorm16/QuantizeUnorm16)
+template<>
+inline void VertexBufferLayout::Push<short>(unsigned int count)
+{
+	m_Elements.push_back({ GL_SHORT, count, GL_TRUE, 0 });
+	m_Stride += VertexBufferElement::GetSizeOfType(GL_SHORT) * count;
+}
+
+template<>
+inline void VertexBufferLayout::Push<unsigned short>(unsigned int count)
+{
+	m_Elements.push_back({ GL_UNSIGNED_SHORT, count, GL_TRUE, 0 });
+	m_Stride += VertexBufferElement::GetSizeOfType(GL_UNSIGNED_SHORT) * count;
+}
+
+// count is the number of components the shader sees and has to be 4 (GL only allows vec4 here),
+// they all fit in one 4 byte word
+template<>
+inline void VertexBufferLayout::Push<PackedInt2101010>(unsigned int count)
+{
+	ASSERT(count == 4);
+	m_Elements.push_back({ GL_INT_2_10_10_10_REV, count, GL_TRUE, 0 });
+	m_Stride += VertexBufferElement::GetSizeOfElement(GL_INT_2_10_10_10_REV, count);
+}
\ No newline at end of file
@@ -0,0 +1,160 @@
+#include "VertexFormat.h"
+
+#include <cmath>
+#include <cstring>
+
+#include "VertexBufferLayout.h"
+
+Half FloatToHalf(float value)
+{
+    unsigned int bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+
+    unsigned int sign = (bits >> 16) & 0x8000;
+    unsigned int exponent = (bits >> 23) & 0xFF;
+    unsigned int mantissa = bits & 0x7FFFFF;
+
+    // inf / nan, keep nan a nan
+    if (exponent == 0xFF)
+        return { (unsigned short)(sign | 0x7C00 | (mantissa ? 0x200 : 0)) };
+
+    int halfExponent = (int)exponent - 127 + 15;
+    if (halfExponent >= 31)
+        return { (unsigned short)(sign | 0x7C00) };
+
+    if (halfExponent <= 0)
+    {
+        // denormal or zero
+        if (halfExponent < -10)
+            return { (unsigned short)sign };
+        mantissa |= 0x800000;
+        unsigned int shift = (unsigned int)(14 - halfExponent);
+        unsigned int half = mantissa >> shift;
+        // round to nearest even
+        unsigned int rest = mantissa & ((1u << shift) - 1);
+        unsigned int halfway = 1u << (shift - 1);
+        if (rest > halfway || (rest == halfway && (half & 1)))
+            half++;
+        return { (unsigned short)(sign | half) };
+    }
+
+    unsigned int half = ((unsigned int)halfExponent << 10) | (mantissa >> 13);
+    unsigned int rest = mantissa & 0x1FFF;
+    // a carry out of the mantissa bumps the exponent, which is exactly what rounding wants (up to inf)
+    if (rest > 0x1000 || (rest == 0x1000 && (half & 1)))
+        half++;
+    return { (unsigned short)(sign | half) };
+}
+
+float HalfToFloat(Half value)
+{
+    unsigned int sign = (unsigned int)(value.bits & 0x8000) << 16;
+    unsigned int exponent = (value.bits >> 10) & 0x1F;
+    unsigned int mantissa = value.bits & 0x3FF;
+
+    unsigned int bits;
+    if (exponent == 0x1F)
+    {
+        bits = sign | 0x7F800000 | (mantissa << 13);
+    }
+    else if (exponent == 0)
+    {
+        // denormals are exact in float
+        float result = std::ldexp((float)mantissa, -24);
+        return sign ? -result : result;
+    }
+    else
+    {
+        bits = sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+    }
+
+    float result;
+    std::memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+static float Clamp(float value, float low, float high)
+{
+    // also catches nan
+    return value >= low ? (value <= high ? value : high) : low;
+}
+
+short QuantizeSnorm16(float value)
+{
+    return (short)std::lround(Clamp(value, -1.0f, 1.0f) * 32767.0f);
+}
+
+unsigned short QuantizeUnorm16(float value)
+{
+    return (unsigned short)std::lround(Clamp(value, 0.0f, 1.0f) * 65535.0f);
+}
+
+unsigned char QuantizeUnorm8(float value)
+{
+    return (unsigned char)std::lround(Clamp(value, 0.0f, 1.0f) * 255.0f);
+}
+
+PackedInt2101010 PackSnorm2101010(float x, float y, float z, float w)
+{
+    unsigned int bits = 0;
+    bits |= ((unsigned int)std::lround(Clamp(x, -1.0f, 1.0f) * 511.0f) & 0x3FF);
+    bits |= ((unsigned int)std::lround(Clamp(y, -1.0f, 1.0f) * 511.0f) & 0x3FF) << 10;
+    bits |= ((unsigned int)std::lround(Clamp(z, -1.0f, 1.0f) * 511.0f) & 0x3FF) << 20;
+    bits |= ((unsigned int)std::lround(Clamp(w, -1.0f, 1.0f)) & 0x3) << 30;
+    return { bits };
+}
+
+void QuantizeAttribute(const float* src, unsigned int srcStride, void* dst, unsigned int dstStride,
+    unsigned int vertexCount, unsigned int components, unsigned int type)
+{
+    const bool packed = type == GL_INT_2_10_10_10_REV;
+    ASSERT(!packed || components == 3 || components == 4);
+    if (srcStride == 0)
+        srcStride = components * sizeof(float);
+    if (dstStride == 0)
+        dstStride = VertexBufferElement::GetSizeOfElement(type, packed ? 4 : components);
+
+    const unsigned char* in = (const unsigned char*)src;
+    unsigned char* out = (unsigned char*)dst;
+    for (unsigned int v = 0; v < vertexCount; v++, in += srcStride, out += dstStride)
+    {
+        const float* values = (const float*)in;
+        if (packed)
+        {
+            PackedInt2101010 word = PackSnorm2101010(values[0], values[1], values[2], components == 4 ? values[3] : 0.0f);
+            std::memcpy(out, &word, sizeof(word));
+            continue;
+        }
+
+        // memcpy per component, interleaved destinations aren't necessarily aligned
+        for (unsigned int c = 0; c < components; c++)
+        {
+            switch (type)
+            {
+            case GL_HALF_FLOAT:
+            {
+                Half half = FloatToHalf(values[c]);
+                std::memcpy(out + c * 2, &half, 2);
+                break;
+            }
+            case GL_SHORT:
+            {
+                short value = QuantizeSnorm16(values[c]);
+                std::memcpy(out + c * 2, &value, 2);
+                break;
+            }
+            case GL_UNSIGNED_SHORT:
+            {
+                unsigned short value = QuantizeUnorm16(values[c]);
+                std::memcpy(out + c * 2, &value, 2);
+                break;
+            }
+            case GL_UNSIGNED_BYTE:
+                out[c] = QuantizeUnorm8(values[c]);
+                break;
+            default:
+                ASSERT(false);
+            }
+        }
+    }
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+// Compact vertex attribute formats and the CPU side conversions into them.
+// Half and PackedInt2101010 only exist so VertexBufferLayout::Push<T> can tell them apart from plain integers.
+
+// IEEE 754 binary16, GL_HALF_FLOAT
+struct Half
+{
+	unsigned short bits;
+};
+
+// GL_INT_2_10_10_10_REV: x, y, z in 10 bits and w in 2 bits, signed normalized, x in the low bits
+struct PackedInt2101010
+{
+	unsigned int bits;
+};
+
+Half FloatToHalf(float value);
+float HalfToFloat(Half value);
+
+// [-1, 1] -> short / [0, 1] -> unsigned short / [0, 1] -> unsigned char, rounded to nearest
+short QuantizeSnorm16(float value);
+unsigned short QuantizeUnorm16(float value);
+unsigned char QuantizeUnorm8(float value);
+
+// normals/tangents in [-1, 1], w ends up as -1, 0 or 1 (tangent handedness)
+PackedInt2101010 PackSnorm2101010(float x, float y, float z, float w = 0.0f);
+
+// Converts vertexCount attributes of `components` floats each into `type`
+// (GL_HALF_FLOAT, GL_SHORT, GL_UNSIGNED_SHORT, GL_UNSIGNED_BYTE or GL_INT_2_10_10_10_REV, the integer ones normalized).
+// Strides are in bytes so it can read from and write into interleaved vertices; 0 = tightly packed.
+// For GL_INT_2_10_10_10_REV, components is 3 or 4 and each attribute becomes one 4 byte word.
+void QuantizeAttribute(const float* src, unsigned int srcStride, void* dst, unsigned int dstStride,
+	unsigned int vertexCount, unsigned int components, unsigned int type);
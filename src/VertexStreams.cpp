@@ -0,0 +1,38 @@
+#include "VertexStreams.h"
+
+#include <cstring>
+
+VertexStreams SplitPositionStream(const void* vertices, unsigned int vertexCount, const VertexBufferLayout& layout, unsigned int positionElement)
+{
+    const auto& elements = layout.GetElements();
+    ASSERT(positionElement < elements.size());
+
+    VertexStreams streams;
+    for (unsigned int i = 0; i < elements.size(); i++)
+    {
+        if (i == positionElement)
+            streams.positionLayout.PushElement(elements[i]);
+        else
+            streams.attributeLayout.PushElement(elements[i]);
+    }
+
+    const unsigned int stride = layout.GetStride();
+    const unsigned int positionOffset = layout.GetOffset(positionElement);
+    const unsigned int positionSize = streams.positionLayout.GetStride();
+    const unsigned int attributeStride = streams.attributeLayout.GetStride();
+    streams.positions.resize((size_t)vertexCount * positionSize);
+    streams.attributes.resize((size_t)vertexCount * attributeStride);
+
+    // the other elements keep their order, so everything before the position moves as one block and so does everything after it
+    const unsigned char* in = (const unsigned char*)vertices;
+    unsigned char* positions = streams.positions.data();
+    unsigned char* attributes = streams.attributes.data();
+    for (unsigned int v = 0; v < vertexCount; v++, in += stride, positions += positionSize, attributes += attributeStride)
+    {
+        std::memcpy(positions, in + positionOffset, positionSize);
+        std::memcpy(attributes, in, positionOffset);
+        std::memcpy(attributes + positionOffset, in + positionOffset + positionSize, stride - positionOffset - positionSize);
+    }
+
+    return streams;
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <vector>
+
+#include "VertexBufferLayout.h"
+
+// Interleaved vertices split into two de-interleaved streams: positions alone and everything else.
+// Depth prepasses and shadow passes only bind the position stream and fetch a fraction of the
+// bytes; the main pass adds both streams to one VertexArray.
+struct VertexStreams
+{
+	std::vector<unsigned char> positions;
+	VertexBufferLayout positionLayout;
+	std::vector<unsigned char> attributes;
+	VertexBufferLayout attributeLayout;
+};
+
+// positionElement - index of the position element in layout
+VertexStreams SplitPositionStream(const void* vertices, unsigned int vertexCount, const VertexBufferLayout& layout, unsigned int positionElement = 0);
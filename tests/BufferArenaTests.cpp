@@ -0,0 +1,109 @@
+#include <random>
+#include <vector>
+
+#include "Test.h"
+#include "BufferArena.h"
+
+GL_TEST(BufferArenaCoalescesNeighbours)
+{
+    BufferArena arena(1024);
+    BufferAllocation a = arena.Allocate(100, 1);
+    BufferAllocation b = arena.Allocate(200, 1);
+    BufferAllocation c = arena.Allocate(300, 1);
+    CHECK(a.offset == 0 && b.offset == 100 && c.offset == 300);
+    CHECK(arena.GetBlockCount() == 1 && arena.GetUsedBytes() == 600);
+
+    // b merges with both sides, the block is one free range again
+    arena.Free(a);
+    arena.Free(c);
+    arena.Free(b);
+    CHECK(arena.GetUsedBytes() == 0);
+    BufferAllocation whole = arena.Allocate(1024, 1);
+    CHECK(whole.block == 0 && whole.offset == 0);
+    CHECK(arena.GetBlockCount() == 1);
+    arena.Free(whole);
+
+    // the other way around, merging into the previous range
+    a = arena.Allocate(100, 1);
+    b = arena.Allocate(200, 1);
+    c = arena.Allocate(724, 1);
+    arena.Free(b);
+    arena.Free(a);
+    BufferAllocation merged = arena.Allocate(300, 1);
+    CHECK(merged.block == 0 && merged.offset == 0);
+}
+
+GL_TEST(BufferArenaBestFitAndAlignment)
+{
+    BufferArena arena(1024);
+    BufferAllocation a = arena.Allocate(100, 1);
+    BufferAllocation b = arena.Allocate(100, 1);
+    arena.Free(a);
+    // the 100 byte hole fits better than the rest of the block
+    BufferAllocation small = arena.Allocate(80, 1);
+    CHECK(small.offset == 0);
+
+    // [90, 100) is left of the hole, too small for 16 bytes. The tail starts at 200, so the aligned
+    // allocation leaves [200, 208) free, which is then the best fit for 6 bytes
+    BufferAllocation odd = arena.Allocate(10, 1);
+    CHECK(odd.offset == 80 && b.offset == 100);
+    BufferAllocation aligned = arena.Allocate(16, 16);
+    CHECK(aligned.offset == 208);
+    BufferAllocation padding = arena.Allocate(6, 1);
+    CHECK(padding.offset == 200);
+
+    // too big for a regular block, gets one of its own
+    BufferAllocation big = arena.Allocate(4096, 16);
+    CHECK(big.block == 1 && big.offset == 0 && arena.GetBlockCount() == 2);
+}
+
+GL_TEST(BufferArenaRandomAllocations)
+{
+    const unsigned int blockSize = 4096;
+    BufferArena arena(blockSize);
+    std::mt19937 rng(1);
+    std::vector<BufferAllocation> live;
+    bool aligned = true;
+    for (int i = 0; i < 20000; i++)
+    {
+        if (live.empty() || rng() % 2)
+        {
+            const unsigned int alignment = 1u << (rng() % 6);
+            BufferAllocation allocation = arena.Allocate(1 + rng() % 700, alignment);
+            aligned &= allocation.offset % alignment == 0;
+            live.push_back(allocation);
+        }
+        else
+        {
+            size_t index = rng() % live.size();
+            arena.Free(live[index]);
+            live[index] = live.back();
+            live.pop_back();
+        }
+    }
+    CHECK(aligned);
+
+    bool overlap = false;
+    for (size_t i = 0; i < live.size(); i++)
+    {
+        for (size_t j = i + 1; j < live.size(); j++)
+        {
+            const BufferAllocation& x = live[i];
+            const BufferAllocation& y = live[j];
+            overlap |= x.block == y.block && x.offset < y.offset + y.size && y.offset < x.offset + x.size;
+        }
+    }
+    CHECK(!overlap);
+
+    // with everything freed each block has to be a single range again
+    for (const BufferAllocation& allocation : live)
+        arena.Free(allocation);
+    CHECK(arena.GetUsedBytes() == 0);
+    const unsigned int blocks = arena.GetBlockCount();
+    for (unsigned int i = 0; i < blocks; i++)
+    {
+        BufferAllocation whole = arena.Allocate(blockSize, 1);
+        CHECK(whole.block == i && whole.offset == 0);
+    }
+    CHECK(arena.GetBlockCount() == blocks);
+}
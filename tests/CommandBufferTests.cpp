@@ -0,0 +1,116 @@
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "Test.h"
+#include "CommandBuffer.h"
+#include "Renderer.h"
+
+static std::vector<SortEntry> MakeEntries(const std::vector<uint64_t>& keys, std::vector<RenderCommand>& commands)
+{
+    // the commands only serve as identities, to check stability
+    commands.assign(keys.size(), RenderCommand());
+    std::vector<SortEntry> entries;
+    for (size_t i = 0; i < keys.size(); i++)
+        entries.push_back({ keys[i], &commands[i] });
+    return entries;
+}
+
+TEST(RadixSortMatchesStableSort)
+{
+    std::mt19937_64 rng(7);
+    std::vector<uint64_t> keys;
+    for (int i = 0; i < 5000; i++)
+    {
+        // few distinct values per byte, so there are plenty of equal keys
+        keys.push_back((rng() % 4) << 56 | (rng() % 3) << 32 | (rng() % 5));
+    }
+
+    std::vector<RenderCommand> commands;
+    std::vector<SortEntry> entries = MakeEntries(keys, commands), scratch;
+    std::vector<SortEntry> expected = entries;
+    std::stable_sort(expected.begin(), expected.end(), [](const SortEntry& a, const SortEntry& b) { return a.key < b.key; });
+
+    RadixSort(entries, scratch);
+    bool same = entries.size() == expected.size();
+    for (size_t i = 0; same && i < entries.size(); i++)
+        same = entries[i].key == expected[i].key && entries[i].command == expected[i].command;
+    CHECK(same);
+}
+
+TEST(RadixSortSkippedPasses)
+{
+    // only one byte differs, 7 of the 8 passes are skipped, the result must still end up in entries
+    std::vector<uint64_t> keys = { 0x1100000000000003ull, 0x1100000000000001ull, 0x1100000000000002ull, 0x1100000000000001ull };
+    std::vector<RenderCommand> commands;
+    std::vector<SortEntry> entries = MakeEntries(keys, commands), scratch;
+    RadixSort(entries, scratch);
+
+    CHECK(entries[0].key == 0x1100000000000001ull && entries[0].command == &commands[1]);
+    CHECK(entries[1].key == 0x1100000000000001ull && entries[1].command == &commands[3]);
+    CHECK(entries[2].key == 0x1100000000000002ull);
+    CHECK(entries[3].key == 0x1100000000000003ull);
+
+    // all equal, nothing moves
+    keys.assign(4, 42);
+    entries = MakeEntries(keys, commands);
+    RadixSort(entries, scratch);
+    for (size_t i = 0; i < entries.size(); i++)
+        CHECK(entries[i].command == &commands[i]);
+}
+
+TEST(RadixSortEmptyAndSingle)
+{
+    std::vector<SortEntry> entries, scratch;
+    RadixSort(entries, scratch);
+    CHECK(entries.empty());
+
+    RenderCommand command = {};
+    entries.push_back({ 5, &command });
+    RadixSort(entries, scratch);
+    CHECK(entries.size() == 1 && entries[0].command == &command);
+}
+
+static const char* s_SortVertex = "#version 330 core\nlayout(location = 0) in vec4 position;\nvoid main() { gl_Position = position; }\n";
+static const char* s_SortFragment = "#version 330 core\nout vec4 color;\nvoid main() { color = vec4(1.0); }\n";
+
+GL_TEST(CommandBufferSortsByShaderThenVertexArray)
+{
+    ShaderProgramSource source;
+    source.VertexSource = s_SortVertex;
+    source.FragmentSource = s_SortFragment;
+    Shader first(source, "first"), second(source, "second");
+    VertexArray a, b;
+    unsigned int indices[] = { 0, 1, 2 };
+    IndexBuffer ib(indices, 3);
+
+    // the shader is the most significant part of the key, depth the least
+    const Shader& low = first.GetRendererID() < second.GetRendererID() ? first : second;
+    const Shader& high = &low == &first ? second : first;
+    const VertexArray& lowVa = a.GetRendererID() < b.GetRendererID() ? a : b;
+    const VertexArray& highVa = &lowVa == &a ? b : a;
+
+    CommandBuffer commands;
+    commands.Submit(lowVa, ib, high, 0, 0.0f);
+    commands.Submit(highVa, ib, low, 0, 0.5f);
+    commands.Submit(lowVa, ib, low, 1, 0.0f);
+    commands.Submit(lowVa, ib, low, 0, 0.75f);
+    commands.Submit(lowVa, ib, low, 0, 0.25f);
+    CHECK(commands.Size() == 5);
+
+    std::vector<SortEntry> entries, scratch;
+    for (const RenderCommand& command : commands.GetCommands())
+        entries.push_back({ command.key, &command });
+    RadixSort(entries, scratch);
+
+    const std::vector<RenderCommand>& recorded = commands.GetCommands();
+    CHECK(entries[0].command == &recorded[4]);
+    CHECK(entries[1].command == &recorded[3]);
+    CHECK(entries[2].command == &recorded[2]);
+    CHECK(entries[3].command == &recorded[1]);
+    CHECK(entries[4].command == &recorded[0]);
+
+    commands.Clear();
+    CHECK(commands.Size() == 0);
+}
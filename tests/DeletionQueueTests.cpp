@@ -0,0 +1,78 @@
+#include <GL/glew.h>
+
+#include "Test.h"
+#include "DeletionQueue.h"
+
+static unsigned int CreateBuffer()
+{
+    unsigned int id;
+    glGenBuffers(1, &id);
+    // only a bound name is a buffer for glIsBuffer
+    glBindBuffer(GL_ARRAY_BUFFER, id);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    return id;
+}
+
+GL_TEST(DeletionQueueWaitsForLatencyAndFence)
+{
+    DeletionQueue::Flush();
+    DeletionQueue::SetFrameLatency(2);
+
+    unsigned int id = CreateBuffer();
+    DeletionQueue::Enqueue(GLObjectType::Buffer, id);
+    DeletionQueue::Enqueue(GLObjectType::Buffer, 0);
+    CHECK(DeletionQueue::GetPendingCount() == 1);
+
+    // one frame old, kept even though the GPU is idle
+    glFinish();
+    DeletionQueue::EndFrame();
+    CHECK(DeletionQueue::GetPendingCount() == 1 && glIsBuffer(id));
+
+    // old enough and its fence has signaled
+    glFinish();
+    DeletionQueue::EndFrame();
+    CHECK(DeletionQueue::GetPendingCount() == 0 && !glIsBuffer(id));
+}
+
+GL_TEST(DeletionQueueArenaRanges)
+{
+    DeletionQueue::Flush();
+    DeletionQueue::SetFrameLatency(1);
+
+    BufferArena arena(1024);
+    BufferAllocation a = arena.Allocate(100, 1);
+    BufferAllocation b = arena.Allocate(100, 1);
+    DeletionQueue::EnqueueFree(arena, a);
+    CHECK(arena.GetUsedBytes() == 200);
+
+    // back in the arena once the frame is done
+    glFinish();
+    DeletionQueue::EndFrame();
+    CHECK(DeletionQueue::GetPendingCount() == 0 && arena.GetUsedBytes() == 100);
+
+    // a forgotten arena never gets its ranges back
+    DeletionQueue::EnqueueFree(arena, b);
+    DeletionQueue::ForgetArena(arena);
+    CHECK(DeletionQueue::GetPendingCount() == 0);
+    glFinish();
+    DeletionQueue::EndFrame();
+    CHECK(arena.GetUsedBytes() == 100);
+
+    DeletionQueue::SetFrameLatency(2);
+}
+
+GL_TEST(DeletionQueueFlush)
+{
+    DeletionQueue::Flush();
+    DeletionQueue::SetFrameLatency(2);
+    unsigned int first = CreateBuffer();
+    unsigned int second = CreateBuffer();
+    DeletionQueue::Enqueue(GLObjectType::Buffer, first);
+    DeletionQueue::EndFrame();
+    DeletionQueue::Enqueue(GLObjectType::Buffer, second);
+
+    // the batch waiting for its frames and what came after it
+    CHECK(DeletionQueue::GetPendingCount() == 2);
+    DeletionQueue::Flush();
+    CHECK(DeletionQueue::GetPendingCount() == 0 && !glIsBuffer(first) && !glIsBuffer(second));
+}
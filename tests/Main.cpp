@@ -0,0 +1,62 @@
+#include <iostream>
+#include <memory>
+#include <string>
+
+#include "Test.h"
+#include "Context.h"
+#include "DeletionQueue.h"
+
+static bool s_Failed = false;
+
+std::vector<TestCase>& Test::GetTests()
+{
+    static std::vector<TestCase> tests;
+    return tests;
+}
+
+void Test::Fail(const char* expression, const char* file, int line)
+{
+    std::cout << "    " << file << ":" << line << ": CHECK(" << expression << ") failed" << std::endl;
+    s_Failed = true;
+}
+
+// klgl_tests [filter] - runs the tests whose name contains filter, all of them by default
+int main(int argc, char** argv)
+{
+    const std::string filter = argc > 1 ? argv[1] : "";
+
+    std::unique_ptr<Context> context;
+    bool triedContext = false;
+    unsigned int passed = 0, failed = 0, skipped = 0;
+    for (const TestCase& test : Test::GetTests())
+    {
+        if (std::string(test.name).find(filter) == std::string::npos)
+            continue;
+
+        // only created when a GL test actually runs, the rest works without a GPU
+        if (test.needsGL && !triedContext)
+        {
+            triedContext = true;
+            context = std::make_unique<Context>(ContextType::Headless, 64, 64, "klgl_tests");
+            if (!context->IsValid())
+                context.reset();
+        }
+        if (test.needsGL && !context)
+        {
+            std::cout << "[ SKIP ] " << test.name << " (no GL context)" << std::endl;
+            skipped++;
+            continue;
+        }
+
+        s_Failed = false;
+        test.function();
+        std::cout << (s_Failed ? "[ FAIL ] " : "[  OK  ] ") << test.name << std::endl;
+        (s_Failed ? failed : passed)++;
+    }
+
+    if (context)
+        DeletionQueue::Flush();
+
+    std::cout << passed << " passed, " << failed << " failed, " << skipped << " skipped" << std::endl;
+    return failed == 0 ? 0 : 1;
+}
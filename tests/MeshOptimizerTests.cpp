@@ -0,0 +1,160 @@
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "Test.h"
+#include "MeshOptimizer.h"
+
+// n x n quads on each face of a cube, float3 positions, corners shared within a face only
+static void MakeBox(unsigned int n, std::vector<unsigned char>& vertices, std::vector<unsigned int>& indices)
+{
+    std::vector<float> positions;
+    for (int face = 0; face < 6; face++)
+    {
+        const int axis = face / 2;
+        const float side = face % 2 ? 1.0f : -1.0f;
+        const unsigned int first = (unsigned int)positions.size() / 3;
+        for (unsigned int y = 0; y <= n; y++)
+        {
+            for (unsigned int x = 0; x <= n; x++)
+            {
+                float p[3];
+                p[axis] = side;
+                p[(axis + 1) % 3] = -1.0f + 2.0f * x / n;
+                p[(axis + 2) % 3] = -1.0f + 2.0f * y / n;
+                positions.insert(positions.end(), p, p + 3);
+            }
+        }
+        for (unsigned int y = 0; y < n; y++)
+        {
+            for (unsigned int x = 0; x < n; x++)
+            {
+                unsigned int i = first + y * (n + 1) + x;
+                unsigned int quad[6] = { i, i + 1, i + n + 2, i + n + 2, i + n + 1, i };
+                indices.insert(indices.end(), quad, quad + 6);
+            }
+        }
+    }
+    vertices.resize(positions.size() * sizeof(float));
+    std::memcpy(vertices.data(), positions.data(), vertices.size());
+}
+
+// triangles rotated so the smallest index comes first (keeps the winding), sorted
+static std::vector<std::array<unsigned int, 3>> Triangles(const std::vector<unsigned int>& indices)
+{
+    std::vector<std::array<unsigned int, 3>> triangles;
+    for (size_t i = 0; i + 2 < indices.size(); i += 3)
+    {
+        std::array<unsigned int, 3> t = { indices[i], indices[i + 1], indices[i + 2] };
+        std::rotate(t.begin(), std::min_element(t.begin(), t.end()), t.end());
+        triangles.push_back(t);
+    }
+    std::sort(triangles.begin(), triangles.end());
+    return triangles;
+}
+
+static void ShuffleTriangles(std::vector<unsigned int>& indices, unsigned int seed)
+{
+    std::vector<std::array<unsigned int, 3>> triangles;
+    for (size_t i = 0; i < indices.size(); i += 3)
+        triangles.push_back({ indices[i], indices[i + 1], indices[i + 2] });
+    std::shuffle(triangles.begin(), triangles.end(), std::mt19937(seed));
+    indices.clear();
+    for (const auto& t : triangles)
+        indices.insert(indices.end(), t.begin(), t.end());
+}
+
+TEST(MeshOptimizerVertexCacheKeepsTriangles)
+{
+    std::vector<unsigned char> vertices;
+    std::vector<unsigned int> indices;
+    MakeBox(8, vertices, indices);
+    ShuffleTriangles(indices, 3);
+    const unsigned int vertexCount = (unsigned int)vertices.size() / 12;
+    const float before = MeshOptimizer::AnalyzeVertexCache(indices, vertexCount).acmr;
+
+    std::vector<unsigned int> forsyth = indices, tipsify = indices;
+    MeshOptimizer::OptimizeVertexCache(forsyth, vertexCount);
+    MeshOptimizer::OptimizeVertexCacheTipsify(tipsify, vertexCount);
+    CHECK(Triangles(forsyth) == Triangles(indices));
+    CHECK(Triangles(tipsify) == Triangles(indices));
+    CHECK(MeshOptimizer::AnalyzeVertexCache(forsyth, vertexCount).acmr < before);
+    CHECK(MeshOptimizer::AnalyzeVertexCache(tipsify, vertexCount).acmr < before);
+}
+
+TEST(MeshOptimizerOverdrawKeepsTriangles)
+{
+    std::vector<unsigned char> vertices;
+    std::vector<unsigned int> indices;
+    MakeBox(8, vertices, indices);
+    const unsigned int vertexCount = (unsigned int)vertices.size() / 12;
+    MeshOptimizer::OptimizeVertexCache(indices, vertexCount);
+    // a degenerate triangle first doesn't miss all three vertices, the triangles in front of the
+    // first cold-cache triangle used to get lost
+    const unsigned int degenerate[] = { indices[0], indices[0], indices[1] };
+    indices.insert(indices.begin(), degenerate, degenerate + 3);
+
+    for (float threshold : { 1.0f, 1.05f, 2.0f })
+    {
+        std::vector<unsigned int> sorted = indices;
+        MeshOptimizer::OptimizeOverdraw(sorted, vertices, 12, 3, threshold);
+        CHECK(sorted.size() == indices.size());
+        CHECK(Triangles(sorted) == Triangles(indices));
+    }
+}
+
+TEST(MeshOptimizerWeldAndFetch)
+{
+    // two triangles of a quad with their own copies of the shared corners, plus an unused vertex
+    const float positions[] = { 0, 0, 0,  1, 0, 0,  1, 1, 0,  1, 1, 0,  0, 1, 0,  0, 0, 0,  5, 5, 5 };
+    std::vector<unsigned char> vertices((const unsigned char*)positions, (const unsigned char*)positions + sizeof(positions));
+    std::vector<unsigned int> indices = { 0, 1, 2, 3, 4, 5 };
+
+    CHECK(MeshOptimizer::WeldVertices(vertices, 12, indices) == 5);
+    CHECK(indices[3] == indices[2] && indices[5] == indices[0]);
+
+    // reversed, so the fetch order is the opposite of the vertex order
+    std::reverse(indices.begin(), indices.end());
+    CHECK(MeshOptimizer::OptimizeVertexFetch(vertices, 12, indices) == 4);
+    CHECK(vertices.size() == 4 * 12);
+    unsigned int next = 0;
+    bool firstUseOrder = true;
+    for (unsigned int index : indices)
+    {
+        if (index == next)
+            next++;
+        else
+            firstUseOrder &= index < next;
+    }
+    CHECK(firstUseOrder && next == 4);
+}
+
+TEST(MeshOptimizerOptimize)
+{
+    std::vector<unsigned char> vertices;
+    std::vector<unsigned int> indices;
+    MakeBox(6, vertices, indices);
+    ShuffleTriangles(indices, 5);
+    const size_t indexCount = indices.size();
+
+    MeshOptimizeReport report = MeshOptimizer::Optimize(vertices, 12, indices);
+    CHECK(indices.size() == indexCount);
+    CHECK(report.after.triangleCount == report.before.triangleCount);
+    CHECK(report.after.acmr < report.before.acmr);
+    CHECK(report.after.vertexCount == vertices.size() / 12);
+
+    unsigned int largest = 0;
+    for (unsigned int index : indices)
+        largest = std::max(largest, index);
+    CHECK(largest + 1 == report.after.vertexCount);
+}
+
+TEST(MeshOptimizerAnalyze)
+{
+    VertexCacheStats stats = MeshOptimizer::AnalyzeVertexCache({ 0, 1, 2, 2, 1, 3 }, 4);
+    CHECK(stats.triangleCount == 2 && stats.vertexCount == 4);
+    CHECK(stats.transformedVertices == 4);
+    CHECK(stats.acmr == 2.0f && stats.atvr == 1.0f);
+}
@@ -0,0 +1,118 @@
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#include <GL/glew.h>
+
+#include "Test.h"
+#include "ProgramBinaryCache.h"
+
+static const char* s_VertexSource = "#version 330 core\nvoid main() { gl_Position = vec4(0.0); }\n";
+static const char* s_FragmentSource = "#version 330 core\nout vec4 color;\nvoid main() { color = vec4(1.0); }\n";
+
+static unsigned int LinkProgram()
+{
+    unsigned int program = glCreateProgram();
+    const char* sources[2] = { s_VertexSource, s_FragmentSource };
+    const GLenum types[2] = { GL_VERTEX_SHADER, GL_FRAGMENT_SHADER };
+    for (int i = 0; i < 2; i++)
+    {
+        unsigned int shader = glCreateShader(types[i]);
+        glShaderSource(shader, 1, &sources[i], nullptr);
+        glCompileShader(shader);
+        glAttachShader(program, shader);
+        glDeleteShader(shader);
+    }
+    ProgramBinaryCache::PrepareForStore(program);
+    glLinkProgram(program);
+    return program;
+}
+
+static std::string CachePath(uint64_t key)
+{
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)key);
+    return (std::filesystem::temp_directory_path() / "klgl_tests" / "binaries" / name).string();
+}
+
+// overwrites size bytes at offset in the cached file, offsets as in the header:
+// magic 0, version 4, key 8, format 16, length 20
+static void Corrupt(uint64_t key, size_t offset, const void* data, size_t size)
+{
+    const std::string path = CachePath(key);
+    std::string bytes;
+    {
+        std::ifstream file(path, std::ios::binary);
+        bytes.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+    if (offset + size <= bytes.size())
+        std::memcpy(&bytes[offset], data, size);
+    std::ofstream(path, std::ios::binary | std::ios::trunc) << bytes;
+}
+
+// stores the program again, corrupts the entry and expects a miss that removes it
+static bool RejectsCorrupt(uint64_t key, unsigned int program, size_t offset, const void* data, size_t size)
+{
+    ProgramBinaryCache::Store(key, program);
+    Corrupt(key, offset, data, size);
+
+    const unsigned int misses = ProgramBinaryCache::GetMissCount();
+    unsigned int loaded = ProgramBinaryCache::Load(key);
+    if (loaded)
+        glDeleteProgram(loaded);
+    return !loaded && ProgramBinaryCache::GetMissCount() == misses + 1 && !std::filesystem::exists(CachePath(key));
+}
+
+GL_TEST(ProgramBinaryCacheRoundTripAndRejects)
+{
+    const std::filesystem::path directory = std::filesystem::temp_directory_path() / "klgl_tests" / "binaries";
+    std::filesystem::remove_all(directory);
+    ProgramBinaryCache::SetDirectory(directory.string());
+    // some drivers hand out no binary formats, nothing to test then
+    if (!ProgramBinaryCache::IsEnabled())
+    {
+        ProgramBinaryCache::SetDirectory("");
+        return;
+    }
+
+    const uint64_t key = ProgramBinaryCache::MakeKey({ s_VertexSource, s_FragmentSource });
+    CHECK(key != ProgramBinaryCache::MakeKey({ s_FragmentSource, s_VertexSource }));
+
+    unsigned int program = LinkProgram();
+    GLint linked = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    CHECK(linked == GL_TRUE);
+
+    // nothing stored yet
+    const unsigned int misses = ProgramBinaryCache::GetMissCount();
+    CHECK(ProgramBinaryCache::Load(key) == 0 && ProgramBinaryCache::GetMissCount() == misses + 1);
+
+    ProgramBinaryCache::Store(key, program);
+    const unsigned int hits = ProgramBinaryCache::GetHitCount();
+    unsigned int loaded = ProgramBinaryCache::Load(key);
+    CHECK(loaded != 0 && ProgramBinaryCache::GetHitCount() == hits + 1);
+    if (loaded)
+    {
+        glGetProgramiv(loaded, GL_LINK_STATUS, &linked);
+        CHECK(linked == GL_TRUE);
+        glDeleteProgram(loaded);
+    }
+
+    const char magic[4] = { 'N', 'O', 'P', 'E' };
+    const uint32_t version = 1000;
+    const uint64_t otherKey = key + 1;
+    const uint32_t format = 0xFFFFFFFF;
+    const uint32_t length = 0x7FFFFFFF;
+    CHECK(RejectsCorrupt(key, program, 0, magic, sizeof(magic)));
+    CHECK(RejectsCorrupt(key, program, 4, &version, sizeof(version)));
+    CHECK(RejectsCorrupt(key, program, 8, &otherKey, sizeof(otherKey)));
+    CHECK(RejectsCorrupt(key, program, 16, &format, sizeof(format)));
+    // longer than the file, must not try to allocate it
+    CHECK(RejectsCorrupt(key, program, 20, &length, sizeof(length)));
+
+    glDeleteProgram(program);
+    ProgramBinaryCache::SetDirectory("");
+}
@@ -0,0 +1,68 @@
+#include <string>
+
+#include "Test.h"
+#include "ResourceRegistry.h"
+
+// counts live instances, to see that Destroy really destroys
+struct Tracked
+{
+    static int s_Alive;
+    int value;
+
+    Tracked(int v) : value(v) { s_Alive++; }
+    Tracked(Tracked&& other) noexcept : value(other.value) { s_Alive++; }
+    ~Tracked() { s_Alive--; }
+};
+
+int Tracked::s_Alive = 0;
+
+TEST(ResourceRegistryGenerations)
+{
+    ResourceRegistry<std::string> registry;
+    Handle<std::string> a = registry.Create("a");
+    Handle<std::string> b = registry.Create(3, 'b');
+    CHECK(!a.IsNull() && a != b);
+    CHECK(*registry.Get(a) == "a" && *registry.Get(b) == "bbb");
+    CHECK(registry.GetCount() == 2);
+
+    CHECK(registry.Destroy(a));
+    CHECK(!registry.Destroy(a));
+    CHECK(!registry.IsValid(a) && registry.Get(a) == nullptr);
+
+    // the slot comes back with a new generation, the old handle stays dead
+    Handle<std::string> c = registry.Create("c");
+    CHECK(c.index == a.index && c.generation != a.generation);
+    CHECK(registry.Get(a) == nullptr && *registry.Get(c) == "c");
+    CHECK(registry.GetCount() == 2);
+}
+
+TEST(ResourceRegistryNullAndOutOfRange)
+{
+    ResourceRegistry<int> registry;
+    Handle<int> null;
+    CHECK(null.IsNull() && !registry.IsValid(null) && registry.Get(null) == nullptr);
+    CHECK(!registry.Destroy(null));
+    CHECK(registry.Get(Handle<int>{ 5, 1 }) == nullptr);
+}
+
+TEST(ResourceRegistryDestroysResources)
+{
+    {
+        ResourceRegistry<Tracked> registry;
+        Handle<Tracked> a = registry.Create(1);
+        registry.Create(2);
+        registry.Add(Tracked(3));
+        CHECK(Tracked::s_Alive == 3);
+        registry.Destroy(a);
+        CHECK(Tracked::s_Alive == 2);
+
+        int sum = 0, count = 0;
+        registry.ForEach([&](Handle<Tracked> handle, Tracked& resource)
+        {
+            sum += resource.value;
+            count += registry.Get(handle) == &resource;
+        });
+        CHECK(sum == 5 && count == 2);
+    }
+    CHECK(Tracked::s_Alive == 0);
+}
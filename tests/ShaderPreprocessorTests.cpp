@@ -0,0 +1,182 @@
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+#include "Test.h"
+#include "ShaderPreprocessor.h"
+
+static std::string TestPath(const std::string& name)
+{
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "klgl_tests";
+    std::filesystem::create_directories(directory);
+    return (directory / name).lexically_normal().string();
+}
+
+static std::string WriteFile(const std::string& name, const std::string& text)
+{
+    const std::string path = TestPath(name);
+    std::ofstream(path, std::ios::binary) << text;
+    return path;
+}
+
+TEST(ShaderPreprocessorStages)
+{
+    const std::string path = WriteFile("stages.shader",
+        "ignored, outside of any stage\n"
+        "#shader vertex\n"
+        "void vs() {}\n"
+        "#shader geometry\n"
+        "void gs() {}\n"
+        "#shader fragment\n"
+        "void fs() {}\n");
+
+    ShaderProgramSource source = ShaderPreprocessor::Preprocess(path);
+    // numbered like the file, not from the start of the stage
+    CHECK(source.VertexSource == "#line 3 0\nvoid vs() {}\n");
+    CHECK(source.GeometrySource == "#line 5 0\nvoid gs() {}\n");
+    CHECK(source.FragmentSource == "#line 7 0\nvoid fs() {}\n");
+    CHECK(source.ComputeSource.empty() && source.TessControlSource.empty() && source.TessEvaluationSource.empty());
+    CHECK(source.Files.size() == 1 && source.Files[0] == path);
+    CHECK(std::string(ShaderPreprocessor::GetStageName(ShaderStage::TessEvaluation)) == "tess_evaluation");
+}
+
+TEST(ShaderPreprocessorIncludes)
+{
+    WriteFile("inner.glsl", "#include \"common.glsl\"\nfloat inner;\n");
+    WriteFile("common.glsl", "#include \"inner.glsl\"\nfloat common;\n");
+    const std::string path = WriteFile("includes.shader",
+        "#shader vertex\n"
+        "#include \"common.glsl\"\n"
+        "#include \"common.glsl\"\n"
+        "void main() {}\n"
+        "#shader fragment\n"
+        "#include \"inner.glsl\"\n"
+        "void main() {}\n");
+
+    ShaderProgramSource source = ShaderPreprocessor::Preprocess(path);
+    // common includes inner, whose include of common is the cycle that's cut. The second include
+    // in the same stage is dropped too, both leave an empty line so the numbers stay right
+    CHECK(source.VertexSource ==
+        "#line 2 0\n"
+        "#line 1 1\n"
+        "#line 1 2\n"
+        "\n"
+        "float inner;\n"
+        "#line 2 1\n"
+        "float common;\n"
+        "#line 3 0\n"
+        "\n"
+        "void main() {}\n");
+    // once per stage, the fragment stage gets both again
+    CHECK(source.FragmentSource ==
+        "#line 6 0\n"
+        "#line 1 2\n"
+        "#line 1 1\n"
+        "\n"
+        "float common;\n"
+        "#line 2 2\n"
+        "float inner;\n"
+        "#line 7 0\n"
+        "void main() {}\n");
+    CHECK(source.Files.size() == 3 && source.Files[1] == TestPath("common.glsl") && source.Files[2] == TestPath("inner.glsl"));
+}
+
+TEST(ShaderPreprocessorDefines)
+{
+    const std::string path = WriteFile("defines.shader",
+        "#shader vertex\n"
+        "#version 330 core\n"
+        "void main() {}\n"
+        "#shader fragment\n"
+        "void main() {}\n");
+
+    ShaderProgramSource source = ShaderPreprocessor::Preprocess(path, { "A 1", "B" });
+    // after #version, whose own line stays as an empty one
+    CHECK(source.VertexSource == "#version 330 core\n#define A 1\n#define B\n#line 2 0\n\nvoid main() {}\n");
+    // no #version, in front
+    CHECK(source.FragmentSource == "#define A 1\n#define B\n#line 5 0\nvoid main() {}\n");
+
+    // the same line numbers without defines, so all variants of a file report the same lines
+    source = ShaderPreprocessor::Preprocess(path);
+    CHECK(source.VertexSource == "#version 330 core\n#line 2 0\n\nvoid main() {}\n");
+}
+
+TEST(ShaderPreprocessorIncludeCycleToRoot)
+{
+    std::filesystem::create_directories(TestPath("inc"));
+    WriteFile("inc/cycle.glsl", "float k;\n#include \"../cycle.shader\"\n");
+    const std::string path = WriteFile("cycle.shader",
+        "#shader vertex\n"
+        "#version 330 core\n"
+        "#include \"inc/cycle.glsl\"\n"
+        "void main() {}\n"
+        "#shader fragment\n"
+        "void fragment() {}\n");
+
+    // the include back to the .shader file is cut like any other cycle
+    ShaderProgramSource source = ShaderPreprocessor::Preprocess(path);
+    CHECK(source.VertexSource ==
+        "#version 330 core\n#line 2 0\n"
+        "\n"
+        "#line 1 1\n"
+        "float k;\n"
+        "\n"
+        "#line 4 0\n"
+        "void main() {}\n");
+    CHECK(source.FragmentSource == "#line 6 0\nvoid fragment() {}\n");
+    CHECK(source.Files.size() == 2);
+}
+
+TEST(ShaderPreprocessorVersionInInclude)
+{
+    WriteFile("version.glsl", "// header\n#version 330 core\nfloat k;\n");
+    const std::string path = WriteFile("version.shader",
+        "#shader vertex\n"
+        "#include \"version.glsl\"\n"
+        "void main() {}\n");
+
+    // #version has to be the very first line, even in front of the include's #line
+    ShaderProgramSource source = ShaderPreprocessor::Preprocess(path, { "A" });
+    CHECK(source.VertexSource ==
+        "#version 330 core\n#define A\n#line 2 0\n"
+        "#line 1 1\n"
+        "// header\n"
+        "\n"
+        "float k;\n"
+        "#line 3 0\n"
+        "void main() {}\n");
+}
+
+TEST(ShaderPreprocessorCache)
+{
+    WriteFile("cached.glsl", "float a;\n");
+    const std::string path = WriteFile("cached.shader", "#shader vertex\n#include \"cached.glsl\"\nvoid main() {}\n");
+
+    ShaderPreprocessor::Preprocess(path);
+    unsigned int hits = ShaderPreprocessor::GetCacheHitCount();
+    unsigned int misses = ShaderPreprocessor::GetCacheMissCount();
+    ShaderProgramSource source = ShaderPreprocessor::Preprocess(path);
+    CHECK(ShaderPreprocessor::GetCacheHitCount() == hits + 1);
+    CHECK(source.Files.size() == 2);
+
+    // different defines are a different entry
+    ShaderPreprocessor::Preprocess(path, { "X" });
+    CHECK(ShaderPreprocessor::GetCacheMissCount() == misses + 1);
+
+    // so is a changed include, or a changed file
+    WriteFile("cached.glsl", "float b;\n");
+    source = ShaderPreprocessor::Preprocess(path);
+    CHECK(ShaderPreprocessor::GetCacheMissCount() == misses + 2);
+    CHECK(source.VertexSource.find("float b;") != std::string::npos);
+
+    WriteFile("cached.shader", "#shader vertex\nvoid changed() {}\n");
+    source = ShaderPreprocessor::Preprocess(path);
+    CHECK(ShaderPreprocessor::GetCacheMissCount() == misses + 3);
+    CHECK(source.VertexSource == "#line 2 0\nvoid changed() {}\n" && source.Files.size() == 1);
+}
+
+TEST(ShaderPreprocessorMissingFile)
+{
+    ShaderProgramSource source = ShaderPreprocessor::Preprocess(TestPath("missing.shader"));
+    CHECK(source.Files.empty() && source.VertexSource.empty());
+}
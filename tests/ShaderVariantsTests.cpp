@@ -0,0 +1,46 @@
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "Test.h"
+#include "ShaderVariants.h"
+
+TEST(ShaderVariantsMasks)
+{
+    // nothing is compiled until Get, so this doesn't need GL
+    ShaderVariants variants("unused.shader", { "RED", "GREEN", "BLUE" });
+    CHECK(variants.GetMask("RED") == 1 && variants.GetMask("GREEN") == 2 && variants.GetMask("BLUE") == 4);
+    CHECK(variants.GetMask("NOPE") == 0);
+    CHECK(variants.Normalize(1ull << 40 | 5) == 5);
+    CHECK(!variants.HasVariant(0) && !variants.IsReady(0));
+    CHECK(variants.GetVariantCount() == 0);
+
+    // with all 64 bits in use there's nothing to drop
+    std::vector<std::string> keywords;
+    for (int i = 0; i < 64; i++)
+        keywords.push_back("K" + std::to_string(i));
+    ShaderVariants full("unused.shader", keywords);
+    CHECK(full.Normalize(~0ull) == ~0ull);
+    CHECK(full.GetMask("K63") == 1ull << 63);
+}
+
+GL_TEST(ShaderVariantsQueriesNormalize)
+{
+    const std::filesystem::path path = std::filesystem::temp_directory_path() / "klgl_tests" / "variants.shader";
+    std::filesystem::create_directories(path.parent_path());
+    std::ofstream(path) << "#shader vertex\n#version 330 core\nlayout(location = 0) in vec4 position;\nvoid main() { gl_Position = position; }\n"
+        "#shader fragment\n#version 330 core\nout vec4 color;\nvoid main() { color = vec4(RED + 0.0, 0.0, 0.0, 1.0); }\n";
+
+    ShaderVariants variants(path.string(), { "RED", "GREEN" });
+    const uint64_t red = variants.GetMask("RED");
+    Shader& shader = variants.Get(red | 1ull << 50);
+    // the stray bit is dropped everywhere, so all of these are the same variant
+    CHECK(&variants.Get(red) == &shader);
+    CHECK(variants.HasVariant(red) && variants.HasVariant(red | 1ull << 50));
+    CHECK(!variants.HasVariant(variants.GetMask("GREEN")));
+    CHECK(variants.GetVariantCount() == 1);
+
+    shader.WaitUntilReady();
+    CHECK(variants.IsReady(red | 1ull << 50));
+}
@@ -0,0 +1,53 @@
+#include <cstddef>
+
+#include "Test.h"
+#include "StaticLayout.h"
+
+struct TestVertex
+{
+	float position[3];
+	unsigned char color[4];
+	Half uv[2];
+	PackedInt2101010 normal;
+};
+
+using TestLayout = StaticLayout<Attr<float, 3>, Attr<unsigned char, 4, Normalized>, Attr<Half, 2>, Attr<PackedInt2101010, 4, Normalized>>;
+
+// all compile time
+static_assert(TestLayout::Count == 4, "");
+static_assert(TestLayout::Stride == 24, "");
+static_assert(TestLayout::MatchesStride<TestVertex>(), "");
+static_assert(TestLayout::Offsets[0] == offsetof(TestVertex, position), "");
+static_assert(TestLayout::Offsets[1] == offsetof(TestVertex, color), "");
+static_assert(TestLayout::Offsets[2] == offsetof(TestVertex, uv), "");
+static_assert(TestLayout::Offsets[3] == offsetof(TestVertex, normal), "");
+static_assert(TestLayout::Elements[1].normalized == GL_TRUE, "");
+static_assert(TestLayout::Elements[3].type == GL_INT_2_10_10_10_REV, "");
+
+TEST(StaticLayoutMatchesVertexBufferLayout)
+{
+    VertexBufferLayout layout;
+    layout.Push<float>(3);
+    layout.Push<unsigned char>(4);
+    layout.Push<Half>(2);
+    layout.Push<PackedInt2101010>(4);
+
+    CHECK(layout.GetStride() == TestLayout::Stride);
+    const std::vector<VertexBufferElement>& elements = layout.GetElements();
+    CHECK(elements.size() == TestLayout::Count);
+    for (unsigned int i = 0; i < TestLayout::Count && i < elements.size(); i++)
+    {
+        CHECK(elements[i].type == TestLayout::Elements[i].type);
+        CHECK(elements[i].count == TestLayout::Elements[i].count);
+        CHECK(elements[i].normalized == TestLayout::Elements[i].normalized);
+        CHECK(elements[i].divisor == TestLayout::Elements[i].divisor);
+    }
+}
+
+TEST(StaticLayoutPerInstance)
+{
+    using Layout = StaticLayout<Attr<float, 2>, Attr<float, 4, PerInstance>>;
+    CHECK(Layout::Elements[0].divisor == 0);
+    CHECK(Layout::Elements[1].divisor == 1);
+    CHECK(Layout::Offsets[1] == 8 && Layout::Stride == 24);
+}
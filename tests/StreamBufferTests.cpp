@@ -0,0 +1,55 @@
+#include <cstring>
+
+#include "Test.h"
+#include "StreamBuffer.h"
+
+GL_TEST(StreamBufferRegions)
+{
+    StreamBuffer stream(256, 3);
+    CHECK(stream.GetBuffer().GetSize() == 768);
+
+    unsigned int offset = 1;
+    CHECK(stream.Map(10, offset, 1) != nullptr && offset == 0);
+    stream.Unmap();
+
+    // rounded up to a whole stride, so offset / stride works as base vertex
+    CHECK(stream.Map(24, offset, 12) != nullptr && offset == 12);
+    stream.Unmap();
+
+    // the rest of the region is 220 bytes
+    CHECK(stream.Map(221, offset, 1) == nullptr);
+    CHECK(stream.Map(220, offset, 1) != nullptr && offset == 36);
+    stream.Unmap();
+    CHECK(stream.Map(1, offset, 1) == nullptr);
+
+    // next frame, next region, and around to the first one again
+    stream.Advance();
+    CHECK(stream.Map(16, offset, 16) != nullptr && offset == 256);
+    stream.Unmap();
+    stream.Advance();
+    CHECK(stream.Map(16, offset, 16) != nullptr && offset == 512);
+    stream.Unmap();
+    stream.Advance();
+    CHECK(stream.Map(16, offset, 16) != nullptr && offset == 0);
+    stream.Unmap();
+}
+
+GL_TEST(StreamBufferWritesReachTheBuffer)
+{
+    StreamBuffer stream(64, 2);
+    const float values[4] = { 1.0f, 2.0f, 3.0f, 4.0f };
+
+    unsigned int offset;
+    stream.Advance();
+    void* data = stream.Map(sizeof(values), offset, sizeof(float));
+    CHECK(data != nullptr && offset == 64);
+    if (data)
+        std::memcpy(data, values, sizeof(values));
+    stream.Unmap();
+    glFinish();
+
+    float read[4] = {};
+    stream.GetBuffer().Bind();
+    glGetBufferSubData(GL_ARRAY_BUFFER, offset, sizeof(read), read);
+    CHECK(std::memcmp(read, values, sizeof(values)) == 0);
+}
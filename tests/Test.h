@@ -0,0 +1,30 @@
+#pragma once
+
+#include <vector>
+
+// Tiny test runner for klgl_tests, no dependencies:
+//   TEST(RadixSortIsStable) { ...; CHECK(a == b); }
+//   GL_TEST(...) for tests that need a GL context, skipped when no headless context can be created.
+// A failed CHECK prints and marks the test failed, the test keeps running.
+struct TestCase
+{
+	const char* name;
+	void (*function)();
+	bool needsGL;
+};
+
+namespace Test
+{
+	std::vector<TestCase>& GetTests();
+	void Fail(const char* expression, const char* file, int line);
+
+	struct Registrar
+	{
+		Registrar(const char* name, void (*function)(), bool needsGL) { GetTests().push_back({ name, function, needsGL }); }
+	};
+}
+
+#define TEST(name) static void name(); static Test::Registrar name##Registrar(#name, name, false); static void name()
+#define GL_TEST(name) static void name(); static Test::Registrar name##Registrar(#name, name, true); static void name()
+
+#define CHECK(x) do { if (!(x)) Test::Fail(#x, __FILE__, __LINE__); } while (0)
@@ -0,0 +1,77 @@
+#include <cmath>
+#include <limits>
+
+#include "Test.h"
+#include "VertexFormat.h"
+
+TEST(FloatToHalfExactValues)
+{
+    CHECK(FloatToHalf(0.0f).bits == 0x0000);
+    CHECK(FloatToHalf(-0.0f).bits == 0x8000);
+    CHECK(FloatToHalf(1.0f).bits == 0x3C00);
+    CHECK(FloatToHalf(0.5f).bits == 0x3800);
+    CHECK(FloatToHalf(-2.0f).bits == 0xC000);
+    CHECK(FloatToHalf(65504.0f).bits == 0x7BFF);
+    // smallest denormal
+    CHECK(FloatToHalf(std::ldexp(1.0f, -24)).bits == 0x0001);
+}
+
+TEST(FloatToHalfRounding)
+{
+    // halfway between 1 and the next half (1 + 2^-10) rounds to even, a bit more rounds up
+    CHECK(FloatToHalf(1.0f + std::ldexp(1.0f, -11)).bits == 0x3C00);
+    CHECK(FloatToHalf(1.0f + std::ldexp(3.0f, -11)).bits == 0x3C02);
+    CHECK(FloatToHalf(1.0f + std::ldexp(1.0f, -11) + std::ldexp(1.0f, -20)).bits == 0x3C01);
+    // rounding up out of the largest half, and plain overflow
+    CHECK(FloatToHalf(65520.0f).bits == 0x7C00);
+    CHECK(FloatToHalf(1.0e6f).bits == 0x7C00);
+    CHECK(FloatToHalf(-1.0e6f).bits == 0xFC00);
+    // too small even for a denormal
+    CHECK(FloatToHalf(std::ldexp(1.0f, -26)).bits == 0x0000);
+}
+
+TEST(FloatToHalfSpecials)
+{
+    CHECK(FloatToHalf(std::numeric_limits<float>::infinity()).bits == 0x7C00);
+    CHECK(FloatToHalf(-std::numeric_limits<float>::infinity()).bits == 0xFC00);
+    Half nan = FloatToHalf(std::numeric_limits<float>::quiet_NaN());
+    CHECK((nan.bits & 0x7C00) == 0x7C00 && (nan.bits & 0x3FF) != 0);
+    CHECK(std::isnan(HalfToFloat(nan)));
+}
+
+TEST(HalfRoundTrip)
+{
+    // every finite half survives half -> float -> half
+    bool exact = true;
+    for (unsigned int bits = 0; bits < 0x10000; bits++)
+    {
+        if ((bits & 0x7C00) == 0x7C00)
+            continue;
+        Half half = { (unsigned short)bits };
+        exact &= FloatToHalf(HalfToFloat(half)).bits == bits;
+    }
+    CHECK(exact);
+}
+
+TEST(PackSnorm2101010)
+{
+    // x in the low bits, 10 bit two's complement per component, w in the top 2 bits
+    CHECK(PackSnorm2101010(0.0f, 0.0f, 0.0f).bits == 0);
+    CHECK(PackSnorm2101010(1.0f, 0.0f, 0.0f).bits == 511u);
+    CHECK(PackSnorm2101010(0.0f, -1.0f, 0.0f).bits == 0x201u << 10);
+    CHECK(PackSnorm2101010(0.0f, 0.0f, 1.0f).bits == 511u << 20);
+    CHECK(PackSnorm2101010(0.0f, 0.0f, 0.0f, 1.0f).bits == 1u << 30);
+    CHECK(PackSnorm2101010(0.0f, 0.0f, 0.0f, -1.0f).bits == 3u << 30);
+    // clamped, nan ends up at -1
+    CHECK(PackSnorm2101010(4.0f, 0.0f, 0.0f).bits == 511u);
+    CHECK(PackSnorm2101010(std::numeric_limits<float>::quiet_NaN(), 0.0f, 0.0f).bits == 0x201u);
+    // rounded to nearest: 0.5 * 511 = 255.5
+    CHECK(PackSnorm2101010(0.5f, 0.0f, 0.0f).bits == 256u);
+}
+
+TEST(QuantizeNormalized)
+{
+    CHECK(QuantizeSnorm16(1.0f) == 32767 && QuantizeSnorm16(-1.0f) == -32767 && QuantizeSnorm16(2.0f) == 32767);
+    CHECK(QuantizeUnorm16(1.0f) == 65535 && QuantizeUnorm16(-1.0f) == 0);
+    CHECK(QuantizeUnorm8(0.5f) == 128 && QuantizeUnorm8(1.0f) == 255);
+}
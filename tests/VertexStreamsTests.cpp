@@ -0,0 +1,55 @@
+#include <cstring>
+
+#include "Test.h"
+#include "VertexStreams.h"
+
+struct StreamVertex
+{
+    float uv[2];
+    float position[3];
+    unsigned char color[4];
+};
+
+TEST(VertexStreamsSplitPosition)
+{
+    const StreamVertex vertices[2] = {
+        { { 0.0f, 1.0f }, { 1.0f, 2.0f, 3.0f }, { 10, 20, 30, 40 } },
+        { { 0.5f, 0.5f }, { 4.0f, 5.0f, 6.0f }, { 50, 60, 70, 80 } },
+    };
+    VertexBufferLayout layout;
+    layout.Push<float>(2);
+    layout.Push<float>(3);
+    layout.Push<unsigned char>(4);
+    CHECK(layout.GetStride() == sizeof(StreamVertex));
+
+    VertexStreams streams = SplitPositionStream(vertices, 2, layout, 1);
+    CHECK(streams.positionLayout.GetElements().size() == 1 && streams.positionLayout.GetStride() == 12);
+    CHECK(streams.attributeLayout.GetElements().size() == 2 && streams.attributeLayout.GetStride() == 12);
+    CHECK(streams.attributeLayout.GetElements()[1].type == GL_UNSIGNED_BYTE);
+    CHECK(streams.positions.size() == 24 && streams.attributes.size() == 24);
+
+    // positions packed tightly
+    float positions[6];
+    std::memcpy(positions, streams.positions.data(), sizeof(positions));
+    CHECK(positions[0] == 1.0f && positions[2] == 3.0f && positions[3] == 4.0f && positions[5] == 6.0f);
+
+    // the rest keeps its order: uv, then color
+    const unsigned char* second = streams.attributes.data() + 12;
+    float uv[2];
+    std::memcpy(uv, second, sizeof(uv));
+    CHECK(uv[0] == 0.5f && uv[1] == 0.5f);
+    CHECK(second[8] == 50 && second[11] == 80);
+}
+
+TEST(VertexStreamsPositionOnly)
+{
+    const float vertices[6] = { 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f };
+    VertexBufferLayout layout;
+    layout.Push<float>(3);
+
+    // nothing left for the attribute stream
+    VertexStreams streams = SplitPositionStream(vertices, 2, layout);
+    CHECK(streams.attributeLayout.GetElements().empty() && streams.attributes.empty());
+    CHECK(streams.positions.size() == sizeof(vertices));
+    CHECK(std::memcmp(streams.positions.data(), vertices, sizeof(vertices)) == 0);
+}